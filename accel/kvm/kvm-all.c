@@ -42,6 +42,7 @@
 #include "qapi/visitor.h"
 #include "qapi/qapi-types-common.h"
 #include "qapi/qapi-visit-common.h"
+#include "qapi/qapi-types-migration.h"
 #include "sysemu/reset.h"
 #include "qemu/guest-random.h"
 #include "sysemu/hw_accel.h"
@@ -69,6 +70,8 @@
 #define KVM_GUESTDBG_BLOCKIRQ 0
 #endif
 
+#define KVM_DIRTY_RING_MAX_REAPERS  64
+
 //#define DEBUG_KVM
 
 #ifdef DEBUG_KVM
@@ -648,7 +651,12 @@ static void kvm_dirty_ring_mark_page(KVMState *s, uint32_t as_id,
         return;
     }
 
-    set_bit(offset, mem->dirty_bmap);
+    /* Helper threads may be setting bits in the same bitmap. */
+    if (s->reaper.nr_helpers) {
+        set_bit_atomic(offset, mem->dirty_bmap);
+    } else {
+        set_bit(offset, mem->dirty_bmap);
+    }
 }
 
 static bool dirty_gfn_is_dirtied(struct kvm_dirty_gfn *gfn)
@@ -717,10 +725,85 @@ static uint32_t kvm_dirty_ring_reap_one(KVMState *s, CPUState *cpu)
     }
     cpu->kvm_fetch_index = fetch;
     cpu->dirty_pages += count;
+    if (count > cpu->kvm_dirty_ring_max_fill) {
+        qatomic_set(&cpu->kvm_dirty_ring_max_fill, count);
+    }
 
     return count;
 }
 
+/*
+ * Should be with all slots_lock held for the address spaces.  Reap the
+ * rings of every @nr_parts-th vCPU, starting with @part.
+ */
+static uint64_t kvm_dirty_ring_reap_part(KVMState *s, unsigned int part,
+                                         unsigned int nr_parts)
+{
+    CPUState *cpu;
+    uint64_t total = 0;
+
+    CPU_FOREACH(cpu) {
+        if (cpu->cpu_index % nr_parts == part) {
+            total += kvm_dirty_ring_reap_one(s, cpu);
+        }
+    }
+    return total;
+}
+
+typedef struct KVMDirtyRingReapHelper {
+    QemuThread thread;
+    QemuSemaphore start;
+    KVMState *s;
+    unsigned int part;
+    uint64_t count;
+} KVMDirtyRingReapHelper;
+
+static void *kvm_dirty_ring_reap_helper_thread(void *opaque)
+{
+    KVMDirtyRingReapHelper *h = opaque;
+    struct KVMDirtyRingReaper *r = &h->s->reaper;
+
+    rcu_register_thread();
+
+    while (true) {
+        qemu_sem_wait(&h->start);
+        /*
+         * The thread that started us holds the slots_lock, and waits
+         * for us to finish before releasing it.
+         */
+        WITH_RCU_READ_LOCK_GUARD() {
+            h->count = kvm_dirty_ring_reap_part(h->s, h->part,
+                                                r->nr_helpers + 1);
+        }
+        qemu_sem_post(&r->helpers_done);
+    }
+
+    rcu_unregister_thread();
+    return NULL;
+}
+
+/* Must be with slots_lock held */
+static uint64_t kvm_dirty_ring_reap_all(KVMState *s)
+{
+    struct KVMDirtyRingReaper *r = &s->reaper;
+    uint64_t total;
+    unsigned int i;
+
+    for (i = 0; i < r->nr_helpers; i++) {
+        qemu_sem_post(&r->helpers[i].start);
+    }
+
+    total = kvm_dirty_ring_reap_part(s, 0, r->nr_helpers + 1);
+
+    for (i = 0; i < r->nr_helpers; i++) {
+        qemu_sem_wait(&r->helpers_done);
+    }
+    for (i = 0; i < r->nr_helpers; i++) {
+        total += r->helpers[i].count;
+    }
+    return total;
+}
+
 /* Must be with slots_lock held */
 static uint64_t kvm_dirty_ring_reap_locked(KVMState *s, CPUState* cpu)
 {
@@ -733,9 +816,7 @@ static uint64_t kvm_dirty_ring_reap_locked(KVMState *s, CPUState* cpu)
     if (cpu) {
         total = kvm_dirty_ring_reap_one(s, cpu);
     } else {
-        CPU_FOREACH(cpu) {
-            total += kvm_dirty_ring_reap_one(s, cpu);
-        }
+        total = kvm_dirty_ring_reap_all(s);
     }
 
     if (total) {
@@ -1419,6 +1500,22 @@ static void *kvm_dirty_ring_reaper_thread(void *data)
 static void kvm_dirty_ring_reaper_init(KVMState *s)
 {
     struct KVMDirtyRingReaper *r = &s->reaper;
+    unsigned int i;
+
+    r->nr_helpers = s->kvm_dirty_ring_reapers - 1;
+    r->helpers = g_new0(KVMDirtyRingReapHelper, r->nr_helpers);
+    qemu_sem_init(&r->helpers_done, 0);
+    for (i = 0; i < r->nr_helpers; i++) {
+        KVMDirtyRingReapHelper *h = &r->helpers[i];
+        g_autofree char *name = g_strdup_printf("kvm-reaper-%u", i + 1);
+
+        h->s = s;
+        h->part = i + 1;
+        qemu_sem_init(&h->start, 0);
+        qemu_thread_create(&h->thread, name,
+                           kvm_dirty_ring_reap_helper_thread,
+                           h, QEMU_THREAD_DETACHED);
+    }
 
     qemu_thread_create(&r->reaper_thr, "kvm-reaper",
                        kvm_dirty_ring_reaper_thread,
@@ -2320,6 +2417,34 @@ uint32_t kvm_dirty_ring_size(void)
     return kvm_state->kvm_dirty_ring_size;
 }
 
+DirtyRingStats *kvm_dirty_ring_stats(void)
+{
+    DirtyRingStats *stats;
+    uint8List **fill_tail;
+    uint64List **exits_tail;
+    CPUState *cpu;
+
+    if (!kvm_dirty_ring_enabled()) {
+        return NULL;
+    }
+
+    stats = g_new0(DirtyRingStats, 1);
+    stats->reapers = kvm_state->kvm_dirty_ring_reapers;
+    fill_tail = &stats->vcpu_max_fill;
+    exits_tail = &stats->vcpu_full_exits;
+
+    CPU_FOREACH(cpu) {
+        uint64_t exits = qatomic_read(&cpu->kvm_dirty_ring_full_exits);
+        uint32_t fill = qatomic_read(&cpu->kvm_dirty_ring_max_fill);
+
+        stats->full_exits += exits;
+        QAPI_LIST_APPEND(fill_tail,
+                         (uint64_t)fill * 100 / kvm_state->kvm_dirty_ring_size);
+        QAPI_LIST_APPEND(exits_tail, exits);
+    }
+    return stats;
+}
+
 static int kvm_init(MachineState *ms)
 {
     MachineClass *mc = MACHINE_GET_CLASS(ms);
@@ -2942,6 +3067,8 @@ int kvm_cpu_exec(CPUState *cpu)
              * still full.  Got kicked by KVM_RESET_DIRTY_RINGS.
              */
             trace_kvm_dirty_ring_full(cpu->cpu_index);
+            qatomic_set(&cpu->kvm_dirty_ring_full_exits,
+                        cpu->kvm_dirty_ring_full_exits + 1);
             qemu_mutex_lock_iothread();
             /*
              * We throttle vCPU by making it sleep once it exit from kernel
@@ -3601,6 +3728,40 @@ static void kvm_set_dirty_ring_size(Object *obj, Visitor *v,
     s->kvm_dirty_ring_size = value;
 }
 
+static void kvm_get_dirty_ring_reapers(Object *obj, Visitor *v,
+                                       const char *name, void *opaque,
+                                       Error **errp)
+{
+    KVMState *s = KVM_STATE(obj);
+    uint32_t value = s->kvm_dirty_ring_reapers;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void kvm_set_dirty_ring_reapers(Object *obj, Visitor *v,
+                                       const char *name, void *opaque,
+                                       Error **errp)
+{
+    KVMState *s = KVM_STATE(obj);
+    uint32_t value;
+
+    if (s->fd != -1) {
+        error_setg(errp, "Cannot set properties after the accelerator has been initialized");
+        return;
+    }
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+    if (value < 1 || value > KVM_DIRTY_RING_MAX_REAPERS) {
+        error_setg(errp, "dirty-ring-reapers must be between 1 and %d.",
+                   KVM_DIRTY_RING_MAX_REAPERS);
+        return;
+    }
+
+    s->kvm_dirty_ring_reapers = value;
+}
+
 static void kvm_accel_instance_init(Object *obj)
 {
     KVMState *s = KVM_STATE(obj);
@@ -3613,6 +3774,7 @@ static void kvm_accel_instance_init(Object *obj)
     /* KVM dirty ring is by default off */
     s->kvm_dirty_ring_size = 0;
     s->kvm_dirty_ring_with_bitmap = false;
+    s->kvm_dirty_ring_reapers = 1;
     s->kvm_eager_split_size = 0;
     s->notify_vmexit = NOTIFY_VMEXIT_OPTION_RUN;
     s->notify_window = 0;
@@ -3659,6 +3821,13 @@ static void kvm_accel_class_init(ObjectClass *oc, void *data)
     object_class_property_set_description(oc, "dirty-ring-size",
         "Size of KVM dirty page ring buffer (default: 0, i.e. use bitmap)");
 
+    object_class_property_add(oc, "dirty-ring-reapers", "uint32",
+        kvm_get_dirty_ring_reapers, kvm_set_dirty_ring_reapers,
+        NULL, NULL);
+    object_class_property_set_description(oc, "dirty-ring-reapers",
+        "Number of threads that collect pages from the KVM dirty rings"
+        " (default: 1)");
+
     kvm_arch_accel_class_init(oc);
 }
 
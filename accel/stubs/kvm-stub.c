@@ -124,3 +124,8 @@ uint32_t kvm_dirty_ring_size(void)
 {
     return 0;
 }
+
+struct DirtyRingStats *kvm_dirty_ring_stats(void)
+{
+    return NULL;
+}
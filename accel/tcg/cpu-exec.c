@@ -44,6 +44,7 @@
 #include "tb-context.h"
 #include "internal-common.h"
 #include "internal-target.h"
+#include "profile.h"
 
 /* -icount align implementation. */
 
@@ -215,10 +216,12 @@ static bool tb_lookup_cmp(const void *p, const void *d)
     return false;
 }
 
-static TranslationBlock *tb_htable_lookup(CPUState *cpu, vaddr pc,
-                                          uint64_t cs_base, uint32_t flags,
-                                          uint32_t cflags)
+TranslationBlock *tb_htable_lookup(CPUState *cpu, vaddr pc,
+                                   uint64_t cs_base, uint32_t flags,
+                                   uint32_t cflags)
 {
+    CPUJumpCache *jc = cpu->tb_jmp_cache;
+    TranslationBlock *tb;
     tb_page_addr_t phys_pc;
     struct tb_desc desc;
     uint32_t h;
@@ -235,7 +238,22 @@ static TranslationBlock *tb_htable_lookup(CPUState *cpu, vaddr pc,
     desc.page_addr0 = phys_pc;
     h = tb_hash_func(phys_pc, (cflags & CF_PCREL ? 0 : pc),
                      flags, cs_base, cflags);
-    return qht_lookup_custom(&tb_ctx.htable, &desc, h, tb_lookup_cmp);
+
+    /*
+     * Try the per-vCPU second level before the shared table, whose
+     * buckets are contended when many vCPUs translate at once.
+     */
+    tb = jc->l2[h & (TB_JMP_L2_SIZE - 1)];
+    if (tb && tb_lookup_cmp(tb, &desc)) {
+        qatomic_set(&jc->stats.l2_hits, jc->stats.l2_hits + 1);
+        return tb;
+    }
+    tb = qht_lookup_custom_stats(&tb_ctx.htable, &desc, h, tb_lookup_cmp,
+                                 &jc->stats.qht);
+    if (tb) {
+        jc->l2[h & (TB_JMP_L2_SIZE - 1)] = tb;
+    }
+    return tb;
 }
 
 /* Might cause an exception, so have a longjmp destination ready */
@@ -264,6 +282,7 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
                    tb_cflags(tb) == cflags)) {
             return tb;
         }
+        qatomic_set(&jc->stats.misses, jc->stats.misses + 1);
         tb = tb_htable_lookup(cpu, pc, cs_base, flags, cflags);
         if (tb == NULL) {
             return NULL;
@@ -282,6 +301,7 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
                    tb_cflags(tb) == cflags)) {
             return tb;
         }
+        qatomic_set(&jc->stats.misses, jc->stats.misses + 1);
         tb = tb_htable_lookup(cpu, pc, cs_base, flags, cflags);
         if (tb == NULL) {
             return NULL;
@@ -926,6 +946,11 @@ static inline void cpu_loop_exec_tb(CPUState *cpu, TranslationBlock *tb,
     *last_tb = NULL;
     insns_left = qatomic_read(&cpu->neg.icount_decr.u32);
     if (insns_left < 0) {
+        /* The sampling profiler asks for the PC this way. */
+        if (unlikely(qatomic_read(&cpu->profile_request))) {
+            qatomic_set(&cpu->profile_request, false);
+            tcg_profile_record(log_pc(cpu, tb));
+        }
         /* Something asked us to stop executing chained TBs; just
          * continue round the main loop. Whatever requested the exit
          * will also have set something else (eg exit_request or
@@ -117,6 +117,36 @@ static void tb_jmp_cache_clear_page(CPUState *cpu, vaddr page_addr)
     }
 }
 
+/**
+ * tlb_vtlb_resize_locked() - resize the victim TLB if necessary
+ * @desc: The CPUTLBDesc portion of the TLB
+ * @window_expired: whether the resize window of @desc has expired
+ *
+ * Called with tlb_lock_held, right before the TLB is flushed.
+ *
+ * The victim TLB catches conflict misses in the direct-mapped main TLB,
+ * and is searched linearly on every miss.  When a large share of the
+ * misses are satisfied by it, the guest is likely to benefit from a
+ * larger one, so double its size.  When it is hardly ever hit over a
+ * whole window, the misses are capacity misses that it cannot help
+ * with, and searching it is wasted time; halve its size.
+ */
+static void tlb_vtlb_resize_locked(CPUTLBDesc *desc, bool window_expired)
+{
+    size_t lookups = desc->window_vlookups;
+    size_t rate = lookups ? desc->window_vhits * 100 / lookups : 0;
+
+    if (lookups >= desc->vsize && rate > 30) {
+        qatomic_set(&desc->vsize, MIN(desc->vsize << 1, CPU_VTLB_MAX_SIZE));
+    } else if (rate < 5 && window_expired) {
+        qatomic_set(&desc->vsize, MAX(desc->vsize >> 1, CPU_VTLB_SIZE));
+    } else if (!window_expired) {
+        return;
+    }
+    desc->window_vlookups = 0;
+    desc->window_vhits = 0;
+}
+
 /**
  * tlb_mmu_resize_locked() - perform TLB resize bookkeeping; resize if necessary
  * @desc: The CPUTLBDesc portion of the TLB
@@ -167,6 +197,8 @@ static void tlb_mmu_resize_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast,
     int64_t window_len_ns = window_len_ms * 1000 * 1000;
     bool window_expired = now > desc->window_begin_ns + window_len_ns;
 
+    tlb_vtlb_resize_locked(desc, window_expired);
+
     if (desc->n_used_entries > desc->window_max_entries) {
         desc->window_max_entries = desc->n_used_entries;
     }
@@ -237,9 +269,12 @@ static void tlb_mmu_flush_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast)
     desc->n_used_entries = 0;
     desc->large_page_addr = -1;
     desc->large_page_mask = -1;
+    desc->lp_index = 0;
+    memset(desc->lp_vaddr, -1, sizeof(desc->lp_vaddr));
     desc->vindex = 0;
     memset(fast->table, -1, sizeof_tlb(fast));
-    memset(desc->vtable, -1, sizeof(desc->vtable));
+    /* Entries past vsize are never looked at.  */
+    memset(desc->vtable, -1, desc->vsize * sizeof(desc->vtable[0]));
 }
 
 static void tlb_flush_one_mmuidx_locked(CPUState *cpu, int mmu_idx,
@@ -258,6 +293,9 @@ static void tlb_mmu_init(CPUTLBDesc *desc, CPUTLBDescFast *fast, int64_t now)
 
     tlb_window_reset(desc, now, 0);
     desc->n_used_entries = 0;
+    desc->window_vlookups = 0;
+    desc->window_vhits = 0;
+    desc->vsize = CPU_VTLB_SIZE;
     fast->mask = (n_entries - 1) << CPU_TLB_ENTRY_BITS;
     fast->table = g_new(CPUTLBEntry, n_entries);
     desc->fulltlb = g_new(CPUTLBEntryFull, n_entries);
@@ -322,6 +360,9 @@ static void flush_all_helper(CPUState *src, run_on_cpu_func fn,
     }
 }
 
+static void tlb_flush_queue_range(CPUState *cpu, vaddr addr, vaddr len,
+                                  uint16_t idxmap, unsigned bits);
+
 static void tlb_flush_by_mmuidx_async_work(CPUState *cpu, run_on_cpu_data data)
 {
     uint16_t asked = data.host_int;
@@ -460,7 +501,7 @@ static void tlb_flush_vtlb_page_mask_locked(CPUState *cpu, int mmu_idx,
     int k;
 
     assert_cpu_is_self(cpu);
-    for (k = 0; k < CPU_VTLB_SIZE; k++) {
+    for (k = 0; k < d->vsize; k++) {
         if (tlb_flush_entry_mask_locked(&d->vtable[k], page, mask)) {
             tlb_n_used_entries_dec(cpu, mmu_idx);
         }
@@ -580,22 +621,9 @@ void tlb_flush_page_by_mmuidx(CPUState *cpu, vaddr addr, uint16_t idxmap)
 
     if (qemu_cpu_is_self(cpu)) {
         tlb_flush_page_by_mmuidx_async_0(cpu, addr, idxmap);
-    } else if (idxmap < TARGET_PAGE_SIZE) {
-        /*
-         * Most targets have only a few mmu_idx.  In the case where
-         * we can stuff idxmap into the low TARGET_PAGE_BITS, avoid
-         * allocating memory for this operation.
-         */
-        async_run_on_cpu(cpu, tlb_flush_page_by_mmuidx_async_1,
-                         RUN_ON_CPU_TARGET_PTR(addr | idxmap));
     } else {
-        TLBFlushPageByMMUIdxData *d = g_new(TLBFlushPageByMMUIdxData, 1);
-
-        /* Otherwise allocate a structure, freed by the worker.  */
-        d->addr = addr;
-        d->idxmap = idxmap;
-        async_run_on_cpu(cpu, tlb_flush_page_by_mmuidx_async_2,
-                         RUN_ON_CPU_HOST_PTR(d));
+        tlb_flush_queue_range(cpu, addr, TARGET_PAGE_SIZE, idxmap,
+                              TARGET_LONG_BITS);
     }
 }
 
@@ -607,32 +635,17 @@ void tlb_flush_page(CPUState *cpu, vaddr addr)
 void tlb_flush_page_by_mmuidx_all_cpus(CPUState *src_cpu, vaddr addr,
                                        uint16_t idxmap)
 {
+    CPUState *dst_cpu;
+
     tlb_debug("addr: %016" VADDR_PRIx " mmu_idx:%"PRIx16"\n", addr, idxmap);
 
     /* This should already be page aligned */
     addr &= TARGET_PAGE_MASK;
 
-    /*
-     * Allocate memory to hold addr+idxmap only when needed.
-     * See tlb_flush_page_by_mmuidx for details.
-     */
-    if (idxmap < TARGET_PAGE_SIZE) {
-        flush_all_helper(src_cpu, tlb_flush_page_by_mmuidx_async_1,
-                         RUN_ON_CPU_TARGET_PTR(addr | idxmap));
-    } else {
-        CPUState *dst_cpu;
-
-        /* Allocate a separate data block for each destination cpu.  */
-        CPU_FOREACH(dst_cpu) {
-            if (dst_cpu != src_cpu) {
-                TLBFlushPageByMMUIdxData *d
-                    = g_new(TLBFlushPageByMMUIdxData, 1);
-
-                d->addr = addr;
-                d->idxmap = idxmap;
-                async_run_on_cpu(dst_cpu, tlb_flush_page_by_mmuidx_async_2,
-                                 RUN_ON_CPU_HOST_PTR(d));
-            }
+    CPU_FOREACH(dst_cpu) {
+        if (dst_cpu != src_cpu) {
+            tlb_flush_queue_range(dst_cpu, addr, TARGET_PAGE_SIZE, idxmap,
+                                  TARGET_LONG_BITS);
         }
     }
 
@@ -648,36 +661,32 @@ void tlb_flush_page_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
                                               vaddr addr,
                                               uint16_t idxmap)
 {
+    CPUState *dst_cpu;
+
     tlb_debug("addr: %016" VADDR_PRIx " mmu_idx:%"PRIx16"\n", addr, idxmap);
 
     /* This should already be page aligned */
     addr &= TARGET_PAGE_MASK;
 
+    CPU_FOREACH(dst_cpu) {
+        if (dst_cpu != src_cpu) {
+            tlb_flush_queue_range(dst_cpu, addr, TARGET_PAGE_SIZE, idxmap,
+                                  TARGET_LONG_BITS);
+        }
+    }
+
     /*
      * Allocate memory to hold addr+idxmap only when needed.
-     * See tlb_flush_page_by_mmuidx for details.
+     * Most targets have only a few mmu_idx.  In the case where
+     * we can stuff idxmap into the low TARGET_PAGE_BITS, avoid
+     * allocating memory for this operation.
      */
     if (idxmap < TARGET_PAGE_SIZE) {
-        flush_all_helper(src_cpu, tlb_flush_page_by_mmuidx_async_1,
-                         RUN_ON_CPU_TARGET_PTR(addr | idxmap));
         async_safe_run_on_cpu(src_cpu, tlb_flush_page_by_mmuidx_async_1,
                               RUN_ON_CPU_TARGET_PTR(addr | idxmap));
     } else {
-        CPUState *dst_cpu;
-        TLBFlushPageByMMUIdxData *d;
-
-        /* Allocate a separate data block for each destination cpu.  */
-        CPU_FOREACH(dst_cpu) {
-            if (dst_cpu != src_cpu) {
-                d = g_new(TLBFlushPageByMMUIdxData, 1);
-                d->addr = addr;
-                d->idxmap = idxmap;
-                async_run_on_cpu(dst_cpu, tlb_flush_page_by_mmuidx_async_2,
-                                 RUN_ON_CPU_HOST_PTR(d));
-            }
-        }
+        TLBFlushPageByMMUIdxData *d = g_new(TLBFlushPageByMMUIdxData, 1);
 
-        d = g_new(TLBFlushPageByMMUIdxData, 1);
         d->addr = addr;
         d->idxmap = idxmap;
         async_safe_run_on_cpu(src_cpu, tlb_flush_page_by_mmuidx_async_2,
@@ -740,12 +749,7 @@ static void tlb_flush_range_locked(CPUState *cpu, int midx,
     }
 }
 
-typedef struct {
-    vaddr addr;
-    vaddr len;
-    uint16_t idxmap;
-    uint16_t bits;
-} TLBFlushRangeData;
+typedef CPUTLBPendingFlush TLBFlushRangeData;
 
 static void tlb_flush_range_by_mmuidx_async_0(CPUState *cpu,
                                               TLBFlushRangeData d)
@@ -793,6 +797,132 @@ static void tlb_flush_range_by_mmuidx_async_1(CPUState *cpu,
     g_free(d);
 }
 
+/**
+ * tlb_flush_pending_async_work:
+ * @cpu: cpu on which to flush
+ * @data: unused
+ *
+ * Perform the flushes that other cpus have queued for @cpu with
+ * tlb_flush_queue_range.
+ */
+static void tlb_flush_pending_async_work(CPUState *cpu, run_on_cpu_data data)
+{
+    CPUTLBCommon *c = &cpu->neg.tlb.c;
+    TLBFlushRangeData pending[CPU_TLB_PENDING_FLUSHES];
+    unsigned int i, n;
+    uint16_t full;
+
+    qemu_spin_lock(&c->lock);
+    full = c->pending_full;
+    n = c->n_pending;
+    memcpy(pending, c->pending, n * sizeof(pending[0]));
+    c->pending_full = 0;
+    c->n_pending = 0;
+    c->pending_work = false;
+    qemu_spin_unlock(&c->lock);
+
+    if (full) {
+        tlb_flush_by_mmuidx_async_work(cpu, RUN_ON_CPU_HOST_INT(full));
+    }
+    for (i = 0; i < n; i++) {
+        pending[i].idxmap &= ~full;
+        if (pending[i].idxmap) {
+            tlb_flush_range_by_mmuidx_async_0(cpu, pending[i]);
+        }
+    }
+}
+
+/*
+ * Extend @p to cover [@addr, @addr + @len) if the two ranges overlap or
+ * are adjacent, so that a single flush covers both.
+ */
+static bool tlb_flush_range_merge(TLBFlushRangeData *p, vaddr addr, vaddr len)
+{
+    vaddr p_last = p->addr + p->len - 1;
+    vaddr last = addr + len - 1;
+
+    /* Leave empty and wrapping ranges alone.  */
+    if (last < addr || p_last < p->addr) {
+        return false;
+    }
+    if (addr > p_last + 1 || p->addr > last + 1) {
+        return false;
+    }
+    p->addr = MIN(p->addr, addr);
+    p->len = MAX(p_last, last) - p->addr + 1;
+    return true;
+}
+
+/**
+ * tlb_flush_queue_range:
+ * @cpu: cpu on which to flush, other than the current one
+ * @addr: page aligned start of the range
+ * @len: length of the range
+ * @idxmap: set of mmu_idx to flush
+ * @bits: number of significant bits in the address
+ *
+ * Guest kernels tend to issue their TLB invalidations in bursts, one
+ * page at a time.  Rather than scheduling one work item per page on
+ * @cpu, queue the flush and merge it with the pending ones where
+ * possible.  A single work item performs all of them; as it is queued
+ * by the first request, every flush still happens no later than its
+ * own work item would have.
+ */
+static void tlb_flush_queue_range(CPUState *cpu, vaddr addr, vaddr len,
+                                  uint16_t idxmap, unsigned bits)
+{
+    CPUTLBCommon *c = &cpu->neg.tlb.c;
+    bool need_work;
+    unsigned int i;
+
+    qemu_spin_lock(&c->lock);
+
+    /* Already covered by a pending full flush.  */
+    idxmap &= ~c->pending_full;
+    if (idxmap == 0) {
+        goto merged;
+    }
+
+    for (i = 0; i < c->n_pending; i++) {
+        TLBFlushRangeData *p = &c->pending[i];
+
+        if (p->idxmap == idxmap && p->bits == bits &&
+            tlb_flush_range_merge(p, addr, len)) {
+            goto merged;
+        }
+    }
+
+    if (c->n_pending == CPU_TLB_PENDING_FLUSHES) {
+        /* Too many disjoint ranges, flush the affected mmu_idx instead.  */
+        for (i = 0; i < c->n_pending; i++) {
+            c->pending_full |= c->pending[i].idxmap;
+        }
+        c->pending_full |= idxmap;
+        c->n_pending = 0;
+        goto merged;
+    }
+
+    c->pending[c->n_pending++] = (TLBFlushRangeData) {
+        .addr = addr,
+        .len = len,
+        .idxmap = idxmap,
+        .bits = bits,
+    };
+    need_work = !c->pending_work;
+    c->pending_work = true;
+    qemu_spin_unlock(&c->lock);
+
+    if (need_work) {
+        async_run_on_cpu(cpu, tlb_flush_pending_async_work, RUN_ON_CPU_NULL);
+    }
+    return;
+
+ merged:
+    /* Something is pending, so the work item has been queued already.  */
+    qatomic_set(&c->merge_flush_count, c->merge_flush_count + 1);
+    qemu_spin_unlock(&c->lock);
+}
+
 void tlb_flush_range_by_mmuidx(CPUState *cpu, vaddr addr,
                                vaddr len, uint16_t idxmap,
                                unsigned bits)
@@ -822,10 +952,7 @@ void tlb_flush_range_by_mmuidx(CPUState *cpu, vaddr addr,
     if (qemu_cpu_is_self(cpu)) {
         tlb_flush_range_by_mmuidx_async_0(cpu, d);
     } else {
-        /* Otherwise allocate a structure, freed by the worker.  */
-        TLBFlushRangeData *p = g_memdup(&d, sizeof(d));
-        async_run_on_cpu(cpu, tlb_flush_range_by_mmuidx_async_1,
-                         RUN_ON_CPU_HOST_PTR(p));
+        tlb_flush_queue_range(cpu, d.addr, len, idxmap, bits);
     }
 }
 
@@ -862,13 +989,9 @@ void tlb_flush_range_by_mmuidx_all_cpus(CPUState *src_cpu,
     d.idxmap = idxmap;
     d.bits = bits;
 
-    /* Allocate a separate data block for each destination cpu.  */
     CPU_FOREACH(dst_cpu) {
         if (dst_cpu != src_cpu) {
-            TLBFlushRangeData *p = g_memdup(&d, sizeof(d));
-            async_run_on_cpu(dst_cpu,
-                             tlb_flush_range_by_mmuidx_async_1,
-                             RUN_ON_CPU_HOST_PTR(p));
+            tlb_flush_queue_range(dst_cpu, d.addr, len, idxmap, bits);
         }
     }
 
@@ -912,12 +1035,9 @@ void tlb_flush_range_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
     d.idxmap = idxmap;
     d.bits = bits;
 
-    /* Allocate a separate data block for each destination cpu.  */
     CPU_FOREACH(dst_cpu) {
         if (dst_cpu != src_cpu) {
-            p = g_memdup(&d, sizeof(d));
-            async_run_on_cpu(dst_cpu, tlb_flush_range_by_mmuidx_async_1,
-                             RUN_ON_CPU_HOST_PTR(p));
+            tlb_flush_queue_range(dst_cpu, d.addr, len, idxmap, bits);
         }
     }
 
@@ -1020,7 +1140,8 @@ void tlb_reset_dirty(CPUState *cpu, ram_addr_t start1, ram_addr_t length)
                                          start1, length);
         }
 
-        for (i = 0; i < CPU_VTLB_SIZE; i++) {
+        n = cpu->neg.tlb.d[mmu_idx].vsize;
+        for (i = 0; i < n; i++) {
             tlb_reset_dirty_range_locked(&cpu->neg.tlb.d[mmu_idx].vtable[i],
                                          start1, length);
         }
@@ -1053,7 +1174,7 @@ void tlb_set_dirty(CPUState *cpu, vaddr addr)
 
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
         int k;
-        for (k = 0; k < CPU_VTLB_SIZE; k++) {
+        for (k = 0; k < cpu->neg.tlb.d[mmu_idx].vsize; k++) {
             tlb_set_dirty1_locked(&cpu->neg.tlb.d[mmu_idx].vtable[k], addr);
         }
     }
@@ -1084,6 +1205,89 @@ static void tlb_add_large_page(CPUState *cpu, int mmu_idx,
     cpu->neg.tlb.d[mmu_idx].large_page_mask = lp_mask;
 }
 
+static bool tlb_large_pages_enabled(CPUState *cpu, int mmu_idx)
+{
+    const TCGCPUOps *ops = cpu->cc->tcg_ops;
+
+    return ops->tlb_fill_large_pages &&
+           ops->tlb_fill_large_pages(cpu, mmu_idx);
+}
+
+/*
+ * Remember the translation of the large page containing @addr, so that
+ * the other pages it covers can be filled without calling tlb_fill.
+ */
+static void tlb_record_large_page(CPUState *cpu, int mmu_idx, vaddr addr,
+                                  const CPUTLBEntryFull *full)
+{
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
+    vaddr mask = MAKE_64BIT_MASK(0, full->lg_page_size);
+    size_t i;
+
+    /* The target must check each page, or wants to see every write.  */
+    if (!tlb_large_pages_enabled(cpu, mmu_idx) ||
+        (full->prot & PAGE_WRITE_INV)) {
+        return;
+    }
+
+    addr &= ~mask;
+    for (i = 0; i < CPU_TLB_LARGE_PAGES; i++) {
+        if (desc->lp_vaddr[i] == addr &&
+            desc->lp_full[i].lg_page_size == full->lg_page_size) {
+            /* Refresh it, e.g. with write access once made dirty.  */
+            break;
+        }
+    }
+    if (i == CPU_TLB_LARGE_PAGES) {
+        i = desc->lp_index++ % CPU_TLB_LARGE_PAGES;
+    }
+    desc->lp_vaddr[i] = addr;
+    desc->lp_full[i] = *full;
+    desc->lp_full[i].phys_addr &= ~(hwaddr)mask;
+}
+
+/*
+ * Fill the tlb entry for @addr from a recently filled large page that
+ * covers it and permits @access_type.  Return false if there is none.
+ */
+static bool tlb_fill_large_page(CPUState *cpu, vaddr addr,
+                                MMUAccessType access_type, int mmu_idx)
+{
+    static const int need[] = {
+        [MMU_DATA_LOAD] = PAGE_READ,
+        [MMU_DATA_STORE] = PAGE_WRITE,
+        [MMU_INST_FETCH] = PAGE_EXEC,
+    };
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
+    size_t i;
+
+    /* The configuration may have changed since the page was recorded. */
+    if (!tlb_large_pages_enabled(cpu, mmu_idx)) {
+        return false;
+    }
+
+    for (i = 0; i < CPU_TLB_LARGE_PAGES; i++) {
+        CPUTLBEntryFull *lp = &desc->lp_full[i];
+        vaddr mask;
+
+        if (desc->lp_vaddr[i] == (vaddr)-1) {
+            continue;
+        }
+        mask = MAKE_64BIT_MASK(0, lp->lg_page_size);
+        if (desc->lp_vaddr[i] == (addr & ~mask) &&
+            (lp->prot & need[access_type])) {
+            CPUTLBEntryFull full = *lp;
+
+            full.phys_addr |= addr & mask & TARGET_PAGE_MASK;
+            tlb_set_page_full(cpu, mmu_idx, addr & TARGET_PAGE_MASK, &full);
+            qatomic_set(&cpu->neg.tlb.c.large_page_fill_count,
+                        cpu->neg.tlb.c.large_page_fill_count + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
 static inline void tlb_set_compare(CPUTLBEntryFull *full, CPUTLBEntry *ent,
                                    vaddr address, int flags,
                                    MMUAccessType access_type, bool enable)
@@ -1105,7 +1309,9 @@ static inline void tlb_set_compare(CPUTLBEntryFull *full, CPUTLBEntry *ent,
 /*
  * Add a new TLB entry. At most one entry for a given virtual address
  * is permitted. Only a single TARGET_PAGE_SIZE region is mapped, the
- * supplied size is only used by tlb_flush_page.
+ * supplied size is used by tlb_flush_page, and, if the target allows
+ * it, to fill the other pages of a large page without calling back
+ * into the target.
  *
  * Called from TCG-generated code, which is under an RCU read-side
  * critical section.
@@ -1131,6 +1337,7 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
     } else {
         sz = (hwaddr)1 << full->lg_page_size;
         tlb_add_large_page(cpu, mmu_idx, addr, sz);
+        tlb_record_large_page(cpu, mmu_idx, addr, full);
     }
     addr_page = addr & TARGET_PAGE_MASK;
     paddr_page = full->phys_addr & TARGET_PAGE_MASK;
@@ -1220,7 +1427,7 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
      * different page; otherwise just overwrite the stale data.
      */
     if (!tlb_hit_page_anyprot(te, addr_page) && !tlb_entry_is_empty(te)) {
-        unsigned vidx = desc->vindex++ % CPU_VTLB_SIZE;
+        unsigned vidx = desc->vindex++ % desc->vsize;
         CPUTLBEntry *tv = &desc->vtable[vidx];
 
         /* Evict the old entry into the victim tlb.  */
@@ -1308,6 +1515,10 @@ static void tlb_fill(CPUState *cpu, vaddr addr, int size,
 {
     bool ok;
 
+    if (tlb_fill_large_page(cpu, addr, access_type, mmu_idx)) {
+        return;
+    }
+
     /*
      * This is not a probe, so only valid return is success; failure
      * should result in exception + longjmp to the cpu loop.
@@ -1362,11 +1573,15 @@ static void io_failed(CPUState *cpu, CPUTLBEntryFull *full, vaddr addr,
 static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
                            MMUAccessType access_type, vaddr page)
 {
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
     size_t vidx;
 
     assert_cpu_is_self(cpu);
-    for (vidx = 0; vidx < CPU_VTLB_SIZE; ++vidx) {
-        CPUTLBEntry *vtlb = &cpu->neg.tlb.d[mmu_idx].vtable[vidx];
+    desc->window_vlookups++;
+    qatomic_set(&cpu->neg.tlb.c.miss_count, cpu->neg.tlb.c.miss_count + 1);
+
+    for (vidx = 0; vidx < desc->vsize; ++vidx) {
+        CPUTLBEntry *vtlb = &desc->vtable[vidx];
         uint64_t cmp = tlb_read_idx(vtlb, access_type);
 
         if (cmp == page) {
@@ -1379,10 +1594,14 @@ static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
             copy_tlb_helper_locked(vtlb, &tmptlb);
             qemu_spin_unlock(&cpu->neg.tlb.c.lock);
 
-            CPUTLBEntryFull *f1 = &cpu->neg.tlb.d[mmu_idx].fulltlb[index];
-            CPUTLBEntryFull *f2 = &cpu->neg.tlb.d[mmu_idx].vfulltlb[vidx];
+            CPUTLBEntryFull *f1 = &desc->fulltlb[index];
+            CPUTLBEntryFull *f2 = &desc->vfulltlb[vidx];
             CPUTLBEntryFull tmpf;
             tmpf = *f1; *f1 = *f2; *f2 = tmpf;
+
+            desc->window_vhits++;
+            qatomic_set(&cpu->neg.tlb.c.victim_hit_count,
+                        cpu->neg.tlb.c.victim_hit_count + 1);
             return true;
         }
     }
@@ -1429,7 +1648,8 @@ static int probe_access_internal(CPUState *cpu, vaddr addr,
 
     if (!tlb_hit_page(tlb_addr, page_addr)) {
         if (!victim_tlb_hit(cpu, mmu_idx, index, access_type, page_addr)) {
-            if (!cpu->cc->tcg_ops->tlb_fill(cpu, addr, fault_size, access_type,
+            if (!tlb_fill_large_page(cpu, addr, access_type, mmu_idx) &&
+                !cpu->cc->tcg_ops->tlb_fill(cpu, addr, fault_size, access_type,
                                             mmu_idx, nonfault, retaddr)) {
                 /* Non-faulting page table read failed.  */
                 *phost = NULL;
@@ -19,6 +19,7 @@
 #include "tcg/tcg.h"
 #include "internal-common.h"
 #include "tb-context.h"
+#include "tb-jmp-cache.h"
 
 
 static void dump_drift_info(GString *buf)
@@ -126,19 +127,74 @@ static gboolean tb_tree_stats_iter(gpointer key, gpointer value, gpointer data)
     return false;
 }
 
-static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide)
+static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide,
+                             size_t *pmerge)
 {
     CPUState *cpu;
-    size_t full = 0, part = 0, elide = 0;
+    size_t full = 0, part = 0, elide = 0, merge = 0;
 
     CPU_FOREACH(cpu) {
         full += qatomic_read(&cpu->neg.tlb.c.full_flush_count);
         part += qatomic_read(&cpu->neg.tlb.c.part_flush_count);
         elide += qatomic_read(&cpu->neg.tlb.c.elide_flush_count);
+        merge += qatomic_read(&cpu->neg.tlb.c.merge_flush_count);
     }
     *pfull = full;
     *ppart = part;
     *pelide = elide;
+    *pmerge = merge;
+}
+
+static void tlb_cpu_stats(GString *buf)
+{
+    CPUState *cpu;
+
+    g_string_append_printf(buf, "\nTLB statistics per vCPU:\n");
+    CPU_FOREACH(cpu) {
+        CPUTLB *tlb = &cpu->neg.tlb;
+        /* Read the hits first, they are counted after the misses.  */
+        size_t vhits = qatomic_read(&tlb->c.victim_hit_count);
+        size_t misses = qatomic_read(&tlb->c.miss_count);
+        int i;
+
+        g_string_append_printf(buf, "CPU#%d misses %zu victim hits %zu "
+                               "fills %zu (large page %zu) "
+                               "flushes %zu/%zu/%zu/%zu",
+                               cpu->cpu_index, misses, vhits, misses - vhits,
+                               qatomic_read(&tlb->c.large_page_fill_count),
+                               qatomic_read(&tlb->c.full_flush_count),
+                               qatomic_read(&tlb->c.part_flush_count),
+                               qatomic_read(&tlb->c.elide_flush_count),
+                               qatomic_read(&tlb->c.merge_flush_count));
+        /* Only list the mmu modes whose victim tlb has grown.  */
+        for (i = 0; i < NB_MMU_MODES; i++) {
+            size_t vsize = qatomic_read(&tlb->d[i].vsize);
+
+            if (vsize != CPU_VTLB_SIZE) {
+                g_string_append_printf(buf, " vtlb[%d]=%zu", i, vsize);
+            }
+        }
+        g_string_append_c(buf, '\n');
+    }
+}
+
+static void tb_lookup_counts(CPUJumpCacheStats *st)
+{
+    CPUState *cpu;
+
+    memset(st, 0, sizeof(*st));
+    CPU_FOREACH(cpu) {
+        CPUJumpCache *jc = cpu->tb_jmp_cache;
+
+        if (!jc) {
+            continue;
+        }
+        st->misses += qatomic_read(&jc->stats.misses);
+        st->l2_hits += qatomic_read(&jc->stats.l2_hits);
+        st->qht.lookups += qatomic_read(&jc->stats.qht.lookups);
+        st->qht.probes += qatomic_read(&jc->stats.qht.probes);
+        st->qht.retries += qatomic_read(&jc->stats.qht.retries);
+    }
 }
 
 static void tcg_dump_info(GString *buf)
@@ -150,7 +206,8 @@ static void dump_exec_info(GString *buf)
 {
     struct tb_tree_stats tst = {};
     struct qht_stats hst;
-    size_t nb_tbs, flush_full, flush_part, flush_elide;
+    size_t nb_tbs, flush_full, flush_part, flush_elide, flush_merge;
+    CPUJumpCacheStats lst;
 
     tcg_tb_foreach(tb_tree_stats_iter, &tst);
     nb_tbs = tst.nb_tbs;
@@ -192,10 +249,25 @@ static void dump_exec_info(GString *buf)
     g_string_append_printf(buf, "TB invalidate count %u\n",
                            qatomic_read(&tb_ctx.tb_phys_invalidate_count));
 
-    tlb_flush_counts(&flush_full, &flush_part, &flush_elide);
+    tb_lookup_counts(&lst);
+    g_string_append_printf(buf, "TB jmp cache misses %zu "
+                           "(L2 hit %0.2f%%)\n",
+                           lst.misses,
+                           lst.misses ? (double)lst.l2_hits /
+                           lst.misses * 100 : 0);
+    g_string_append_printf(buf, "TB hash lookups     %zu "
+                           "(avg probe depth %0.3f, retries %zu)\n",
+                           lst.qht.lookups,
+                           lst.qht.lookups ? (double)lst.qht.probes /
+                           lst.qht.lookups : 0,
+                           lst.qht.retries);
+
+    tlb_flush_counts(&flush_full, &flush_part, &flush_elide, &flush_merge);
     g_string_append_printf(buf, "TLB full flushes    %zu\n", flush_full);
     g_string_append_printf(buf, "TLB partial flushes %zu\n", flush_part);
     g_string_append_printf(buf, "TLB elided flushes  %zu\n", flush_elide);
+    g_string_append_printf(buf, "TLB merged flushes  %zu\n", flush_merge);
+    tlb_cpu_stats(buf);
     tcg_dump_info(buf);
 }
 
@@ -0,0 +1,262 @@
+/*
+ * Sampling profiler for guest code.
+ *
+ * Instrumenting every block gives exact counts, but slows the guest
+ * down several times.  Here a thread wakes up periodically and asks
+ * each running vCPU to leave generated code at the start of the next
+ * block, the same way cpu_exit() does but without an exit request, so
+ * the vCPU goes straight back to executing after recording the guest
+ * PC.  The cost is one unchained block per vCPU and sample.
+ *
+ * vCPUs push their samples into a lock-free ring, which the sampling
+ * thread drains into a histogram.  At exit the PCs are symbolized with
+ * debuginfo, where available, and written out in the folded stack
+ * format understood by flamegraph.pl and similar tools: one line per
+ * PC, with the symbol as caller frame, followed by the sample count.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/atomic.h"
+#include "qemu/error-report.h"
+#include "qemu/lockable.h"
+#include "qemu/thread.h"
+#include "hw/core/cpu.h"
+#include "exec/cpu-common.h"
+#ifndef CONFIG_USER_ONLY
+#include "qemu/notify.h"
+#include "sysemu/sysemu.h"
+#endif
+#include "trace.h"
+#include "debuginfo.h"
+#include "profile.h"
+
+#define PROFILE_RING_SIZE   4096
+#define PROFILE_MAX_FREQ    1000
+
+/*
+ * Bounded multi-producer single-consumer queue.  A slot is free for
+ * the producer that claimed position @pos when its sequence number is
+ * @pos, and holds a sample for the consumer at @pos once it is @pos + 1.
+ */
+typedef struct ProfileSlot {
+    uint32_t seq;
+    uint64_t pc;
+} ProfileSlot;
+
+typedef struct ProfileEntry {
+    uint64_t pc;        /* must be first, used as the hash table key */
+    uint64_t count;
+} ProfileEntry;
+
+static struct {
+    bool enabled;
+    char *path;
+    pid_t pid;
+    unsigned period_ms;
+    QemuThread thread;
+
+    ProfileSlot ring[PROFILE_RING_SIZE];
+    uint32_t head;                  /* next position for producers */
+    uint32_t tail;                  /* next position for the consumer */
+    unsigned int dropped;
+
+    /* The fields below are protected by @lock. */
+    QemuMutex lock;
+    GHashTable *hist;               /* guest PC -> ProfileEntry */
+    uint64_t samples;
+} profile;
+
+#ifndef CONFIG_USER_ONLY
+static Notifier profile_exit_notifier;
+#endif
+
+void tcg_profile_record(vaddr pc)
+{
+    uint32_t pos = qatomic_read(&profile.head);
+
+    while (true) {
+        ProfileSlot *slot = &profile.ring[pos % PROFILE_RING_SIZE];
+        int32_t diff = qatomic_load_acquire(&slot->seq) - pos;
+
+        if (diff == 0) {
+            uint32_t old = qatomic_cmpxchg(&profile.head, pos, pos + 1);
+
+            if (old == pos) {
+                slot->pc = pc;
+                qatomic_store_release(&slot->seq, pos + 1);
+                return;
+            }
+            pos = old;
+        } else if (diff < 0) {
+            /* Full: the sampling thread is far behind. */
+            qatomic_inc(&profile.dropped);
+            return;
+        } else {
+            pos = qatomic_read(&profile.head);
+        }
+    }
+}
+
+/* Called with profile.lock held. */
+static void tcg_profile_drain(void)
+{
+    while (true) {
+        uint32_t pos = profile.tail;
+        ProfileSlot *slot = &profile.ring[pos % PROFILE_RING_SIZE];
+        ProfileEntry *e;
+        uint64_t pc;
+
+        if (qatomic_load_acquire(&slot->seq) != pos + 1) {
+            break;
+        }
+        pc = slot->pc;
+        qatomic_store_release(&slot->seq, pos + PROFILE_RING_SIZE);
+        profile.tail = pos + 1;
+
+        e = g_hash_table_lookup(profile.hist, &pc);
+        if (!e) {
+            e = g_new0(ProfileEntry, 1);
+            e->pc = pc;
+            g_hash_table_insert(profile.hist, &e->pc, e);
+        }
+        e->count++;
+        profile.samples++;
+    }
+}
+
+static void tcg_profile_request(void)
+{
+    CPUState *cpu;
+
+    /* Keep vCPUs from going away under us in user mode. */
+    QEMU_LOCK_GUARD(&qemu_cpu_list_lock);
+    CPU_FOREACH(cpu) {
+        /* Halted or blocked in a syscall: nothing to sample. */
+        if (!qatomic_read(&cpu->running)) {
+            continue;
+        }
+        qatomic_set(&cpu->profile_request, true);
+        /* Pairs with the barrier in cpu_handle_interrupt(). */
+        smp_wmb();
+        qatomic_set(&cpu->neg.icount_decr.u16.high, -1);
+    }
+}
+
+static void *tcg_profile_thread(void *opaque)
+{
+    while (qatomic_read(&profile.enabled)) {
+        g_usleep(profile.period_ms * 1000);
+        tcg_profile_request();
+
+        qemu_mutex_lock(&profile.lock);
+        tcg_profile_drain();
+        qemu_mutex_unlock(&profile.lock);
+    }
+    return NULL;
+}
+
+static gint profile_cmp_count(gconstpointer a, gconstpointer b)
+{
+    const ProfileEntry *ea = *(const ProfileEntry **)a;
+    const ProfileEntry *eb = *(const ProfileEntry **)b;
+
+    return ea->count < eb->count ? 1 : ea->count > eb->count ? -1 : 0;
+}
+
+static void tcg_profile_write(void)
+{
+    g_autoptr(GError) err = NULL;
+    g_autoptr(GString) out = g_string_new(NULL);
+    g_autofree struct debuginfo_query *q = NULL;
+    g_autoptr(GPtrArray) entries = g_ptr_array_new();
+    GHashTableIter iter;
+    ProfileEntry *e;
+    guint i, n;
+
+    tcg_profile_drain();
+    g_hash_table_iter_init(&iter, profile.hist);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&e)) {
+        g_ptr_array_add(entries, e);
+    }
+    g_ptr_array_sort(entries, profile_cmp_count);
+    n = entries->len;
+
+    q = g_new0(struct debuginfo_query, n);
+    for (i = 0; i < n; i++) {
+        e = g_ptr_array_index(entries, i);
+        q[i].address = e->pc;
+        q[i].flags = DEBUGINFO_SYMBOL;
+    }
+
+    g_string_append_printf(out, "# %" PRIu64 " samples, %u dropped,"
+                           " %u ms period\n", profile.samples,
+                           qatomic_read(&profile.dropped), profile.period_ms);
+
+    debuginfo_lock();
+    debuginfo_query(q, n);
+    for (i = 0; i < n; i++) {
+        e = g_ptr_array_index(entries, i);
+        if (q[i].symbol) {
+            g_string_append_printf(out, "%s;%s+0x%" PRIx64 " %" PRIu64 "\n",
+                                   q[i].symbol, q[i].symbol, q[i].offset,
+                                   e->count);
+        } else {
+            g_string_append_printf(out, "0x%" PRIx64 " %" PRIu64 "\n",
+                                   e->pc, e->count);
+        }
+    }
+    debuginfo_unlock();
+
+    if (!g_file_set_contents(profile.path, out->str, out->len, &err)) {
+        warn_report("profile: %s", err->message);
+        return;
+    }
+    trace_tcg_profile_write(profile.path, profile.samples, n);
+}
+
+void tcg_profile_exit(void)
+{
+    /* A forked child profiles nothing, leave the parent's file alone. */
+    if (!profile.enabled || profile.pid != getpid()) {
+        return;
+    }
+
+    qatomic_set(&profile.enabled, false);
+    WITH_QEMU_LOCK_GUARD(&profile.lock) {
+        tcg_profile_write();
+    }
+}
+
+#ifndef CONFIG_USER_ONLY
+static void tcg_profile_exit_notify(Notifier *n, void *unused)
+{
+    tcg_profile_exit();
+}
+#endif
+
+void tcg_profile_init(const char *path, unsigned freq)
+{
+    unsigned i;
+
+    freq = MIN(MAX(freq, 1), PROFILE_MAX_FREQ);
+    profile.path = g_strdup(path);
+    profile.pid = getpid();
+    profile.period_ms = 1000 / freq;
+    for (i = 0; i < PROFILE_RING_SIZE; i++) {
+        profile.ring[i].seq = i;
+    }
+    qemu_mutex_init(&profile.lock);
+    profile.hist = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+                                         NULL, g_free);
+    profile.enabled = true;
+
+#ifndef CONFIG_USER_ONLY
+    profile_exit_notifier.notify = tcg_profile_exit_notify;
+    qemu_add_exit_notifier(&profile_exit_notifier);
+#endif
+
+    qemu_thread_create(&profile.thread, "TCG profile", tcg_profile_thread,
+                       NULL, QEMU_THREAD_DETACHED);
+}
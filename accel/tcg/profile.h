@@ -0,0 +1,25 @@
+/*
+ * Sampling profiler for guest code.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef ACCEL_TCG_PROFILE_H
+#define ACCEL_TCG_PROFILE_H
+
+/*
+ * Start sampling the guest PC of all running vCPUs @freq times per
+ * second; the profile is written to @path at exit.
+ */
+void tcg_profile_init(const char *path, unsigned freq);
+
+/*
+ * Called by a vCPU that left generated code because of a sample
+ * request, with the guest PC of the block it was about to execute.
+ */
+void tcg_profile_record(vaddr pc);
+
+/* Write the profile out, if enabled.  */
+void tcg_profile_exit(void);
+
+#endif
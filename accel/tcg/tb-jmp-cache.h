@@ -9,9 +9,25 @@
 #ifndef ACCEL_TCG_TB_JMP_CACHE_H
 #define ACCEL_TCG_TB_JMP_CACHE_H
 
+#include "qemu/qht.h"
+
 #define TB_JMP_CACHE_BITS 12
 #define TB_JMP_CACHE_SIZE (1 << TB_JMP_CACHE_BITS)
 
+#define TB_JMP_L2_BITS 12
+#define TB_JMP_L2_SIZE (1 << TB_JMP_L2_BITS)
+
+/*
+ * Lookup statistics.  Only the vCPU owning the cache writes them;
+ * readers use qatomic_read.  Hits in the jump cache are not counted,
+ * to keep tb_lookup free of stores on its fast path.
+ */
+typedef struct CPUJumpCacheStats {
+    size_t misses;          /* tb_lookup calls that missed the jump cache */
+    size_t l2_hits;         /* ... and then hit in the second level */
+    struct qht_lookup_stats qht;
+} CPUJumpCacheStats;
+
 /*
  * Accessed in parallel; all accesses to 'tb' must be atomic.
  * For CF_PCREL, accesses to 'pc' must be protected by a
@@ -23,6 +39,17 @@ struct CPUJumpCache {
         TranslationBlock *tb;
         vaddr pc;
     } array[TB_JMP_CACHE_SIZE];
+
+    /*
+     * Second level, indexed by the hash of the TB in tb_ctx.htable,
+     * so that it does not depend on the virtual address.  It is only
+     * accessed by the owning vCPU, and entries are checked against the
+     * lookup key before use; invalidated TBs never match because of
+     * CF_INVALID.  It must be cleared when TBs are freed by tb_flush.
+     */
+    TranslationBlock *l2[TB_JMP_L2_SIZE];
+
+    CPUJumpCacheStats stats;
 };
 
 #endif /* ACCEL_TCG_TB_JMP_CACHE_H */
@@ -768,6 +768,10 @@ static void do_tb_flush(CPUState *cpu, run_on_cpu_data tb_flush_count)
 
     CPU_FOREACH(cpu) {
         tcg_flush_jmp_cache(cpu);
+        /* Unlike the first level, the second survives TLB flushes. */
+        if (cpu->tb_jmp_cache) {
+            memset(cpu->tb_jmp_cache->l2, 0, sizeof(cpu->tb_jmp_cache->l2));
+        }
     }
 
     qht_reset_size(&tb_ctx.htable, CODE_GEN_HTABLE_SIZE);
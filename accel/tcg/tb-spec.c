@@ -0,0 +1,128 @@
+/*
+ * Speculative translation of likely successors.
+ *
+ * In user-mode emulation all threads share a single TCGContext, and
+ * translation is serialized by mmap_lock.  A vCPU that reaches code that
+ * has not been translated yet leaves the generated code, looks the block
+ * up, takes mmap_lock and translates it; the guest code it will reach
+ * next is usually known already: the direct jump targets of the block it
+ * has just translated.  Those are translated right away, while the vCPU
+ * still holds mmap_lock, so that it only has to chain to them when it
+ * gets there.
+ *
+ * Translation reads the state of the vCPU it is done for, so it is only
+ * ever done by the thread that runs that vCPU.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/rcu.h"
+#include "exec/exec-all.h"
+#include "tcg/tcg.h"
+#include "trace.h"
+#include "tb-spec.h"
+#include "internal-common.h"
+#include "internal-target.h"
+
+#define TB_SPEC_MAX_DEPTH   2
+#define TB_SPEC_MAX_BLOCKS  4
+
+typedef struct TBSpecRequest {
+    vaddr pc;
+    int depth;
+} TBSpecRequest;
+
+static bool tb_spec_enabled;
+
+/*
+ * Blocks generated for a special purpose (single-stepping, a single insn
+ * after an exception) say nothing about what comes next.
+ */
+static bool tb_spec_useful(TranslationBlock *tb)
+{
+    return tb_page_addr0(tb) != -1 &&
+           !(tb_cflags(tb) & (CF_COUNT_MASK | CF_NO_GOTO_TB | CF_NOIRQ |
+                              CF_SINGLE_STEP | CF_INVALID));
+}
+
+/* Called with mmap_lock held. */
+static TranslationBlock *tb_spec_translate_one(CPUState *cpu,
+                                               TranslationBlock *from,
+                                               vaddr pc)
+{
+    const int need = PAGE_VALID | PAGE_EXEC;
+    vaddr page = pc & TARGET_PAGE_MASK;
+    TranslationBlock *tb;
+
+    /*
+     * A fault while reading guest code would deliver a signal for code
+     * that the guest may never run.  mmap_lock keeps the mappings
+     * stable, so check them up front; the block may extend into the
+     * following page.
+     */
+    if ((page_get_flags(page) & need) != need ||
+        (page_get_flags(page + TARGET_PAGE_SIZE) & need) != need) {
+        return NULL;
+    }
+
+    WITH_RCU_READ_LOCK_GUARD() {
+        tb = tb_htable_lookup(cpu, pc, from->cs_base, from->flags,
+                              tb_cflags(from));
+    }
+    if (tb) {
+        return NULL;
+    }
+
+    return tb_gen_code_spec(cpu, pc, from->cs_base, from->flags,
+                            tb_cflags(from));
+}
+
+void tb_spec_translate(CPUState *cpu, TranslationBlock *tb)
+{
+    TBSpecRequest queue[TB_SPEC_MAX_BLOCKS];
+    TranslationBlock *from[TB_SPEC_MAX_BLOCKS];
+    int head = 0, tail = 0, i;
+
+    if (!tb_spec_enabled || !tb_spec_useful(tb)) {
+        return;
+    }
+
+    /*
+     * Breadth first, so that both targets of a conditional branch are
+     * covered before going deeper.  gen_succ is overwritten by each
+     * translation, so copy it out first.
+     */
+    for (i = 0; i < tcg_ctx->gen_nb_succ && tail < TB_SPEC_MAX_BLOCKS; i++) {
+        from[tail] = tb;
+        queue[tail++] = (TBSpecRequest) { tcg_ctx->gen_succ[i], 1 };
+    }
+
+    while (head < tail) {
+        TBSpecRequest r = queue[head];
+        TranslationBlock *next;
+
+        next = tb_spec_translate_one(cpu, from[head++], r.pc);
+        if (!next) {
+            continue;
+        }
+        trace_tb_spec_translate(r.pc, r.depth);
+        if (r.depth == TB_SPEC_MAX_DEPTH || !tb_spec_useful(next)) {
+            continue;
+        }
+        for (i = 0; i < tcg_ctx->gen_nb_succ; i++) {
+            if (tail == TB_SPEC_MAX_BLOCKS) {
+                trace_tb_spec_drop(tcg_ctx->gen_succ[i]);
+                continue;
+            }
+            from[tail] = next;
+            queue[tail++] = (TBSpecRequest) { tcg_ctx->gen_succ[i],
+                                              r.depth + 1 };
+        }
+    }
+}
+
+void tb_spec_init(void)
+{
+    tb_spec_enabled = true;
+}
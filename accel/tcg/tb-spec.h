@@ -0,0 +1,26 @@
+/*
+ * Speculative translation of likely successors.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef ACCEL_TCG_TB_SPEC_H
+#define ACCEL_TCG_TB_SPEC_H
+
+#ifdef CONFIG_USER_ONLY
+/* Enable speculative translation.  */
+void tb_spec_init(void);
+
+/*
+ * Called by the thread running @cpu with mmap_lock held, right after
+ * @tb has been generated for it.  Translate the direct jump targets of
+ * @tb, and theirs in turn, that are not translated yet.
+ */
+void tb_spec_translate(CPUState *cpu, TranslationBlock *tb);
+#else
+static inline void tb_spec_translate(CPUState *cpu, TranslationBlock *tb)
+{
+}
+#endif
+
+#endif
@@ -29,6 +29,7 @@
 #include "sysemu/cpu-timers.h"
 #include "tcg/startup.h"
 #include "tcg/oversized-guest.h"
+#include "tcg/tcg.h"
 #include "qapi/error.h"
 #include "qemu/error-report.h"
 #include "qemu/accel.h"
@@ -39,14 +40,20 @@
 #include "hw/boards.h"
 #endif
 #include "internal-target.h"
+#include "tb-spec.h"
+#include "profile.h"
 
 struct TCGState {
     AccelState parent_obj;
 
     bool mttcg_enabled;
     bool one_insn_per_tb;
+    bool pin_globals;
+    bool spec_translate;
     int splitwx_enabled;
     unsigned long tb_size;
+    char *profile;
+    uint32_t profile_freq;
 };
 typedef struct TCGState TCGState;
 
@@ -88,6 +95,7 @@ static void tcg_accel_instance_init(Object *obj)
     TCGState *s = TCG_STATE(obj);
 
     s->mttcg_enabled = default_mttcg_enabled();
+    s->profile_freq = 1000;
 
     /* If debugging enabled, default "auto on", otherwise off. */
 #if defined(CONFIG_DEBUG_TCG) && !defined(CONFIG_USER_ONLY)
@@ -122,8 +130,16 @@ static int tcg_init_machine(MachineState *ms)
      * initialize the prologue now.
      */
     tcg_prologue_init();
+#else
+    if (s->spec_translate) {
+        tb_spec_init();
+    }
 #endif
 
+    if (s->profile) {
+        tcg_profile_init(s->profile, s->profile_freq);
+    }
+
     return 0;
 }
 
@@ -181,6 +197,49 @@ static void tcg_set_tb_size(Object *obj, Visitor *v,
     s->tb_size = value;
 }
 
+static char *tcg_get_profile(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+
+    return g_strdup(s->profile);
+}
+
+static void tcg_set_profile(Object *obj, const char *value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+
+    g_free(s->profile);
+    s->profile = g_strdup(value);
+}
+
+static void tcg_get_profile_freq(Object *obj, Visitor *v,
+                                 const char *name, void *opaque,
+                                 Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value = s->profile_freq;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void tcg_set_profile_freq(Object *obj, Visitor *v,
+                                 const char *name, void *opaque,
+                                 Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value;
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+    if (value < 1 || value > 1000) {
+        error_setg(errp, "profile-freq must be between 1 and 1000");
+        return;
+    }
+
+    s->profile_freq = value;
+}
+
 static bool tcg_get_splitwx(Object *obj, Error **errp)
 {
     TCGState *s = TCG_STATE(obj);
@@ -207,6 +266,34 @@ static void tcg_set_one_insn_per_tb(Object *obj, bool value, Error **errp)
     qatomic_set(&one_insn_per_tb, value);
 }
 
+static bool tcg_get_pin_globals(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->pin_globals;
+}
+
+static void tcg_set_pin_globals(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->pin_globals = value;
+    /* Takes effect with the next translation */
+    qatomic_set(&tcg_pin_globals, value);
+}
+
+#ifdef CONFIG_USER_ONLY
+static bool tcg_get_spec_translate(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->spec_translate;
+}
+
+static void tcg_set_spec_translate(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->spec_translate = value;
+}
+#endif
+
 static int tcg_gdbstub_supported_sstep_flags(void)
 {
     /*
@@ -242,6 +329,26 @@ static void tcg_accel_class_init(ObjectClass *oc, void *data)
     object_class_property_set_description(oc, "tb-size",
         "TCG translation block cache size");
 
+#if defined(CONFIG_USER_ONLY)
+    object_class_property_add_bool(oc, "spec-translate",
+                                   tcg_get_spec_translate,
+                                   tcg_set_spec_translate);
+    object_class_property_set_description(oc, "spec-translate",
+        "Translate likely successors ahead of time");
+#endif
+
+    object_class_property_add_str(oc, "profile",
+                                  tcg_get_profile,
+                                  tcg_set_profile);
+    object_class_property_set_description(oc, "profile",
+        "File to write a sampled profile of guest code to at exit");
+
+    object_class_property_add(oc, "profile-freq", "int",
+        tcg_get_profile_freq, tcg_set_profile_freq,
+        NULL, NULL);
+    object_class_property_set_description(oc, "profile-freq",
+        "Samples per second and vCPU taken by the profiler");
+
     object_class_property_add_bool(oc, "split-wx",
         tcg_get_splitwx, tcg_set_splitwx);
     object_class_property_set_description(oc, "split-wx",
@@ -252,6 +359,12 @@ static void tcg_accel_class_init(ObjectClass *oc, void *data)
                                    tcg_set_one_insn_per_tb);
     object_class_property_set_description(oc, "one-insn-per-tb",
         "Only put one guest insn in each translation block");
+
+    object_class_property_add_bool(oc, "pin-globals",
+                                   tcg_get_pin_globals,
+                                   tcg_set_pin_globals);
+    object_class_property_set_description(oc, "pin-globals",
+        "Keep hot guest registers in host registers across a TB");
 }
 
 static const TypeInfo tcg_accel_type = {
@@ -23,6 +23,31 @@
 #include "exec/helper-proto-common.h"
 #include "tcg/tcg-gvec-desc.h"
 
+/*
+ * The operations that move elements between positions number them the
+ * way the shifts of the inline expansions do: each 64-bit unit holds
+ * its elements from the least significant bits up, whatever the host
+ * byte order.
+ */
+#if HOST_BIG_ENDIAN
+#define H1(x)  ((x) ^ 7)
+#define H2(x)  ((x) ^ 3)
+#define H4(x)  ((x) ^ 1)
+#else
+#define H1(x)  (x)
+#define H2(x)  (x)
+#define H4(x)  (x)
+#endif
+#define H8(x)  (x)
+
+/* Return a copy of @s if the destination overlaps it. */
+static inline void *gvec_src(void *buf, void *d, void *s, intptr_t oprsz)
+{
+    if (unlikely((uintptr_t)(d - s) < oprsz || (uintptr_t)(s - d) < oprsz)) {
+        return memcpy(buf, s, oprsz);
+    }
+    return s;
+}
 
 static inline void clear_high(void *d, intptr_t oprsz, uint32_t desc)
 {
@@ -1569,3 +1594,168 @@ void HELPER(gvec_bitsel)(void *d, void *a, void *b, void *c, uint32_t desc)
     }
     clear_high(d, oprsz, desc);
 }
+
+/*
+ * The largest operation size a descriptor can represent, for the
+ * temporaries of operations whose destination may overlap a source.
+ */
+#define GVEC_MAX_OPRSZ  2048
+
+#define DO_ZIP(NAME, TYPE, H)                                           \
+void HELPER(NAME)(void *d, void *a, void *b, uint32_t desc)             \
+{                                                                       \
+    intptr_t oprsz = simd_oprsz(desc);                                  \
+    intptr_t n = oprsz / sizeof(TYPE);                                  \
+    intptr_t base = simd_data(desc) ? n / 2 : 0;                        \
+    uint64_t ta[GVEC_MAX_OPRSZ / 8], tb[GVEC_MAX_OPRSZ / 8];            \
+    TYPE *dd = d, *aa = gvec_src(ta, d, a, oprsz);                      \
+    TYPE *bb = gvec_src(tb, d, b, oprsz);                               \
+    intptr_t i;                                                         \
+                                                                        \
+    for (i = 0; i < n / 2; i++) {                                       \
+        dd[H(2 * i)] = aa[H(base + i)];                                 \
+        dd[H(2 * i + 1)] = bb[H(base + i)];                             \
+    }                                                                   \
+    clear_high(d, oprsz, desc);                                         \
+}
+
+DO_ZIP(gvec_zip8, uint8_t, H1)
+DO_ZIP(gvec_zip16, uint16_t, H2)
+DO_ZIP(gvec_zip32, uint32_t, H4)
+DO_ZIP(gvec_zip64, uint64_t, H8)
+
+#undef DO_ZIP
+
+#define DO_UZP(NAME, TYPE, H)                                           \
+void HELPER(NAME)(void *d, void *a, void *b, uint32_t desc)             \
+{                                                                       \
+    intptr_t oprsz = simd_oprsz(desc);                                  \
+    intptr_t n = oprsz / sizeof(TYPE);                                  \
+    intptr_t odd = simd_data(desc);                                     \
+    uint64_t ta[GVEC_MAX_OPRSZ / 8], tb[GVEC_MAX_OPRSZ / 8];            \
+    TYPE *dd = d, *aa = gvec_src(ta, d, a, oprsz);                      \
+    TYPE *bb = gvec_src(tb, d, b, oprsz);                               \
+    intptr_t i;                                                         \
+                                                                        \
+    for (i = 0; i < n / 2; i++) {                                       \
+        dd[H(i)] = aa[H(2 * i + odd)];                                  \
+        dd[H(n / 2 + i)] = bb[H(2 * i + odd)];                          \
+    }                                                                   \
+    clear_high(d, oprsz, desc);                                         \
+}
+
+DO_UZP(gvec_uzp8, uint8_t, H1)
+DO_UZP(gvec_uzp16, uint16_t, H2)
+DO_UZP(gvec_uzp32, uint32_t, H4)
+DO_UZP(gvec_uzp64, uint64_t, H8)
+
+#undef DO_UZP
+
+/* Each pair of destination elements only depends on the same pair. */
+#define DO_TRN(NAME, TYPE, H)                                           \
+void HELPER(NAME)(void *d, void *a, void *b, uint32_t desc)             \
+{                                                                       \
+    intptr_t oprsz = simd_oprsz(desc);                                  \
+    intptr_t n = oprsz / sizeof(TYPE);                                  \
+    intptr_t odd = simd_data(desc);                                     \
+    TYPE *dd = d, *aa = a, *bb = b;                                     \
+    intptr_t i;                                                         \
+                                                                        \
+    for (i = 0; i < n; i += 2) {                                        \
+        TYPE ae = aa[H(i + odd)];                                       \
+        TYPE be = bb[H(i + odd)];                                       \
+        dd[H(i)] = ae;                                                  \
+        dd[H(i + 1)] = be;                                              \
+    }                                                                   \
+    clear_high(d, oprsz, desc);                                         \
+}
+
+DO_TRN(gvec_trn8, uint8_t, H1)
+DO_TRN(gvec_trn16, uint16_t, H2)
+DO_TRN(gvec_trn32, uint32_t, H4)
+DO_TRN(gvec_trn64, uint64_t, H8)
+
+#undef DO_TRN
+
+#define DO_XTL(NAME, TYPED, TYPES, HD, HS)                              \
+void HELPER(NAME)(void *d, void *a, uint32_t desc)                      \
+{                                                                       \
+    intptr_t oprsz = simd_oprsz(desc);                                  \
+    intptr_t n = oprsz / sizeof(TYPED);                                 \
+    intptr_t base = simd_data(desc) ? n : 0;                            \
+    uint64_t ta[GVEC_MAX_OPRSZ / 8];                                    \
+    TYPED *dd = d;                                                      \
+    TYPES *aa = gvec_src(ta, d, a, oprsz);                              \
+    intptr_t i;                                                         \
+                                                                        \
+    for (i = 0; i < n; i++) {                                           \
+        dd[HD(i)] = aa[HS(base + i)];                                   \
+    }                                                                   \
+    clear_high(d, oprsz, desc);                                         \
+}
+
+DO_XTL(gvec_sxtl8, int16_t, int8_t, H2, H1)
+DO_XTL(gvec_sxtl16, int32_t, int16_t, H4, H2)
+DO_XTL(gvec_sxtl32, int64_t, int32_t, H8, H4)
+
+DO_XTL(gvec_uxtl8, uint16_t, uint8_t, H2, H1)
+DO_XTL(gvec_uxtl16, uint32_t, uint16_t, H4, H2)
+DO_XTL(gvec_uxtl32, uint64_t, uint32_t, H8, H4)
+
+#undef DO_XTL
+
+#define DO_XTN(NAME, TYPED, TYPES, HD, HS)                              \
+void HELPER(NAME)(void *d, void *a, uint32_t desc)                      \
+{                                                                       \
+    intptr_t oprsz = simd_oprsz(desc);                                  \
+    intptr_t n = oprsz / sizeof(TYPES);                                 \
+    bool high = simd_data(desc);                                        \
+    uint64_t ta[GVEC_MAX_OPRSZ / 8];                                    \
+    TYPED *dd = d;                                                      \
+    TYPES *aa = gvec_src(ta, d, a, oprsz);                              \
+    intptr_t i;                                                         \
+                                                                        \
+    for (i = 0; i < n; i++) {                                           \
+        dd[HD(high ? n + i : i)] = aa[HS(i)];                           \
+        if (!high) {                                                    \
+            dd[HD(n + i)] = 0;                                          \
+        }                                                               \
+    }                                                                   \
+    clear_high(d, oprsz, desc);                                         \
+}
+
+DO_XTN(gvec_xtn8, uint8_t, uint16_t, H1, H2)
+DO_XTN(gvec_xtn16, uint16_t, uint32_t, H2, H4)
+DO_XTN(gvec_xtn32, uint32_t, uint64_t, H4, H8)
+
+#undef DO_XTN
+
+/*
+ * Each wide element accumulates the products of the four narrow elements
+ * it overlaps, so their order within it does not matter.
+ */
+#define DO_DOT(NAME, TYPED, TYPEN)                                      \
+void HELPER(NAME)(void *d, void *a, void *b, void *c, uint32_t desc)    \
+{                                                                       \
+    intptr_t oprsz = simd_oprsz(desc);                                  \
+    intptr_t i;                                                         \
+                                                                        \
+    for (i = 0; i < oprsz; i += sizeof(TYPED)) {                        \
+        TYPEN *aa = a + i, *bb = b + i;                                 \
+        TYPED sum = *(TYPED *)(c + i);                                  \
+        int j;                                                          \
+                                                                        \
+        for (j = 0; j < 4; j++) {                                       \
+            sum += (TYPED)aa[j] * bb[j];                                \
+        }                                                               \
+        *(TYPED *)(d + i) = sum;                                        \
+    }                                                                   \
+    clear_high(d, oprsz, desc);                                         \
+}
+
+DO_DOT(gvec_sdot8, int32_t, int8_t)
+DO_DOT(gvec_sdot16, int64_t, int16_t)
+DO_DOT(gvec_udot8, uint32_t, uint8_t)
+DO_DOT(gvec_udot16, uint64_t, uint16_t)
+
+#undef DO_DOT
@@ -64,6 +64,7 @@
 #include "internal-common.h"
 #include "internal-target.h"
 #include "perf.h"
+#include "tb-spec.h"
 #include "tcg/insn-start-words.h"
 
 TBContext tb_ctx;
@@ -284,10 +285,15 @@ static int setjmp_gen_code(CPUArchState *env, TranslationBlock *tb,
     return tcg_gen_code(tcg_ctx, tb, pc);
 }
 
-/* Called with mmap_lock held for user mode emulation.  */
-TranslationBlock *tb_gen_code(CPUState *cpu,
-                              vaddr pc, uint64_t cs_base,
-                              uint32_t flags, int cflags)
+/*
+ * Called with mmap_lock held for user mode emulation.
+ * If @spec, @pc is only a guess at where @cpu goes next: return NULL
+ * rather than leave the cpu loop if the block cannot be generated.
+ */
+static TranslationBlock *tb_gen_code_internal(CPUState *cpu,
+                                              vaddr pc, uint64_t cs_base,
+                                              uint32_t flags, int cflags,
+                                              bool spec)
 {
     CPUArchState *env = cpu_env(cpu);
     TranslationBlock *tb, *existing_tb;
@@ -303,6 +309,9 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     phys_pc = get_page_addr_code_hostp(env, pc, &host_pc);
 
     if (phys_pc == -1) {
+        if (spec) {
+            return NULL;
+        }
         /* Generate a one-shot TB with 1 insn in it */
         cflags = (cflags & ~CF_COUNT_MASK) | 1;
     }
@@ -317,6 +326,10 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     assert_no_pages_locked();
     tb = tcg_tb_alloc(tcg_ctx);
     if (unlikely(!tb)) {
+        if (spec) {
+            /* Leave the flush to the next translation by a vCPU. */
+            return NULL;
+        }
         /* flush must be done */
         tb_flush(cpu);
         mmap_unlock();
@@ -564,6 +577,32 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     return tb;
 }
 
+/* Called with mmap_lock held for user mode emulation.  */
+TranslationBlock *tb_gen_code(CPUState *cpu,
+                              vaddr pc, uint64_t cs_base,
+                              uint32_t flags, int cflags)
+{
+    TranslationBlock *tb;
+
+    tb = tb_gen_code_internal(cpu, pc, cs_base, flags, cflags, false);
+    tb_spec_translate(cpu, tb);
+    return tb;
+}
+
+#ifdef CONFIG_USER_ONLY
+/*
+ * Called with mmap_lock held, to translate ahead of @cpu.
+ * The caller must make sure that reading the guest code cannot fault.
+ * Returns NULL if the code buffer is full.
+ */
+TranslationBlock *tb_gen_code_spec(CPUState *cpu,
+                                   vaddr pc, uint64_t cs_base,
+                                   uint32_t flags, int cflags)
+{
+    return tb_gen_code_internal(cpu, pc, cs_base, flags, cflags, true);
+}
+#endif
+
 /* user-mode: call with mmap_lock held */
 void tb_check_watchpoint(CPUState *cpu, uintptr_t retaddr)
 {
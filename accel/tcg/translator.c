@@ -120,7 +120,20 @@ bool translator_use_goto_tb(DisasContextBase *db, vaddr dest)
     }
 
     /* Check for the dest on the same page as the start of the TB.  */
-    return ((db->pc_first ^ dest) & TARGET_PAGE_MASK) == 0;
+    if (((db->pc_first ^ dest) & TARGET_PAGE_MASK) != 0) {
+        return false;
+    }
+
+    /*
+     * Record the successor as a candidate for speculative translation,
+     * unless plugins watch translations: they would be told about code
+     * that may never run.
+     */
+    if (!db->plugin_enabled &&
+        tcg_ctx->gen_nb_succ < ARRAY_SIZE(tcg_ctx->gen_succ)) {
+        tcg_ctx->gen_succ[tcg_ctx->gen_nb_succ++] = dest;
+    }
+    return true;
 }
 
 void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
@@ -142,6 +155,7 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
     db->saved_can_do_io = -1;
     db->host_addr[0] = host_pc;
     db->host_addr[1] = NULL;
+    tcg_ctx->gen_nb_succ = 0;
 
     ops->init_disas_context(db, cpu);
     tcg_debug_assert(db->is_jmp == DISAS_NEXT);  /* no early exit */
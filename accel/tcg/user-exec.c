@@ -23,6 +23,7 @@
 #include "tcg/tcg.h"
 #include "qemu/bitops.h"
 #include "qemu/rcu.h"
+#include "qemu/seqlock.h"
 #include "exec/cpu_ldst.h"
 #include "exec/translate-all.h"
 #include "exec/helper-proto.h"
@@ -143,7 +144,16 @@ typedef struct PageFlagsNode {
     int flags;
 } PageFlagsNode;
 
+/*
+ * The tree is only modified with mmap_lock held, and nodes are freed
+ * with RCU.  Lookups do not take the lock: util/interval-tree.c only
+ * has false negatives while the tree is being changed, and nodes may be
+ * resized or have their flags changed in place.  All of that happens
+ * within a pageflags_seq write section, so a lockless reader that saw
+ * the sequence unchanged got a consistent answer, and retries otherwise.
+ */
 static IntervalTreeRoot pageflags_root;
+static QemuSeqLock pageflags_seq;
 
 static PageFlagsNode *pageflags_find(target_ulong start, target_ulong last)
 {
@@ -208,24 +218,18 @@ void page_dump(FILE *f)
 
 int page_get_flags(target_ulong address)
 {
-    PageFlagsNode *p = pageflags_find(address, address);
+    PageFlagsNode *p;
+    unsigned seq;
+    int flags;
 
-    /*
-     * See util/interval-tree.c re lockless lookups: no false positives but
-     * there are false negatives.  If we find nothing, retry with the mmap
-     * lock acquired.
-     */
-    if (p) {
-        return p->flags;
-    }
-    if (have_mmap_lock()) {
-        return 0;
-    }
+    RCU_READ_LOCK_GUARD();
+    do {
+        seq = seqlock_read_begin(&pageflags_seq);
+        p = pageflags_find(address, address);
+        flags = p ? qatomic_read(&p->flags) : 0;
+    } while (seqlock_read_retry(&pageflags_seq, seq));
 
-    mmap_lock();
-    p = pageflags_find(address, address);
-    mmap_unlock();
-    return p ? p->flags : 0;
+    return flags;
 }
 
 /* A subroutine of page_set_flags: insert a new node for [start,last]. */
@@ -510,12 +514,17 @@ void page_set_flags(target_ulong start, target_ulong last, int flags)
 
     if (!flags || reset) {
         page_reset_target_data(start, last);
+    }
+    /* Replacing a mapping must look atomic to lockless readers. */
+    seqlock_write_begin(&pageflags_seq);
+    if (!flags || reset) {
         inval_tb |= pageflags_unset(start, last);
     }
     if (flags) {
         inval_tb |= pageflags_set_clear(start, last, flags,
                                         ~(reset ? 0 : PAGE_STICKY));
     }
+    seqlock_write_end(&pageflags_seq);
     if (inval_tb) {
         tb_invalidate_phys_range(start, last);
     }
@@ -523,8 +532,8 @@ void page_set_flags(target_ulong start, target_ulong last, int flags)
 
 bool page_check_range(target_ulong start, target_ulong len, int flags)
 {
-    target_ulong last;
-    int locked;  /* tri-state: =0: unlocked, +1: global, -1: local */
+    target_ulong first = start, last;
+    unsigned seq;
     bool ret;
 
     if (len == 0) {
@@ -536,38 +545,31 @@ bool page_check_range(target_ulong start, target_ulong len, int flags)
         return false; /* wrap around */
     }
 
-    locked = have_mmap_lock();
+    RCU_READ_LOCK_GUARD();
+ retry:
+    seq = seqlock_read_begin(&pageflags_seq);
+    start = first;
     while (true) {
         PageFlagsNode *p = pageflags_find(start, last);
-        int missing;
+        int p_flags, missing;
 
         if (!p) {
-            if (!locked) {
-                /*
-                 * Lockless lookups have false negatives.
-                 * Retry with the lock held.
-                 */
-                mmap_lock();
-                locked = -1;
-                p = pageflags_find(start, last);
-            }
-            if (!p) {
-                ret = false; /* entire region invalid */
-                break;
-            }
+            ret = false; /* entire region invalid */
+            break;
         }
         if (start < p->itree.start) {
             ret = false; /* initial bytes invalid */
             break;
         }
 
-        missing = flags & ~p->flags;
+        p_flags = qatomic_read(&p->flags);
+        missing = flags & ~p_flags;
         if (missing & ~PAGE_WRITE) {
             ret = false; /* page doesn't match */
             break;
         }
         if (missing & PAGE_WRITE) {
-            if (!(p->flags & PAGE_WRITE_ORG)) {
+            if (!(p_flags & PAGE_WRITE_ORG)) {
                 ret = false; /* page not writable */
                 break;
             }
@@ -582,6 +584,8 @@ bool page_check_range(target_ulong start, target_ulong len, int flags)
                 break;
             }
             start += TARGET_PAGE_SIZE;
+            /* That changed the flags, but the pages checked so far are ok. */
+            seq = seqlock_read_begin(&pageflags_seq);
             continue;
         }
 
@@ -592,9 +596,9 @@ bool page_check_range(target_ulong start, target_ulong len, int flags)
         start = p->itree.last + 1;
     }
 
-    /* Release the lock if acquired locally. */
-    if (locked < 0) {
-        mmap_unlock();
+    /* The tree changed under us: the nodes seen may have been stale. */
+    if (seqlock_read_retry(&pageflags_seq, seq)) {
+        goto retry;
     }
     return ret;
 }
@@ -678,7 +682,9 @@ void page_protect(tb_page_addr_t address)
     }
 
     if (prot & PAGE_WRITE) {
+        seqlock_write_begin(&pageflags_seq);
         pageflags_set_clear(start, last, 0, PAGE_WRITE);
+        seqlock_write_end(&pageflags_seq);
         mprotect(g2h_untagged(start), qemu_host_page_size,
                  prot & (PAGE_READ | PAGE_EXEC) ? PROT_READ : PROT_NONE);
     }
@@ -732,7 +738,9 @@ int page_unprotect(target_ulong address, uintptr_t pc)
             start = address & TARGET_PAGE_MASK;
             len = TARGET_PAGE_SIZE;
             prot = p->flags | PAGE_WRITE;
+            seqlock_write_begin(&pageflags_seq);
             pageflags_set_clear(start, start + len - 1, PAGE_WRITE, 0);
+            seqlock_write_end(&pageflags_seq);
             current_tb_invalidated = tb_invalidate_phys_page_unwind(start, pc);
         } else {
             start = address & qemu_host_page_mask;
@@ -747,8 +755,10 @@ int page_unprotect(target_ulong address, uintptr_t pc)
                     prot |= p->flags;
                     if (p->flags & PAGE_WRITE_ORG) {
                         prot |= PAGE_WRITE;
+                        seqlock_write_begin(&pageflags_seq);
                         pageflags_set_clear(addr, addr + TARGET_PAGE_SIZE - 1,
                                             PAGE_WRITE, 0);
+                        seqlock_write_end(&pageflags_seq);
                     }
                 }
                 /*
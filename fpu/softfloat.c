@@ -401,6 +401,82 @@ float64_gen2(float64 xa, float64 xb, float_status *s,
     return soft(ua.s, ub.s, s);
 }
 
+/*
+ * Batched flavors of the above, for @n elements at a time; @d may be
+ * the same array as @a or @b.  When every element of a chunk can be
+ * computed on the host without raising a flag, the chunk is computed
+ * by a loop without branches, which the compiler is free to vectorize.
+ * Otherwise the chunk is redone one element at a time.  Either way the
+ * results and flags are those of the scalar operation.
+ */
+#define HARDFLOAT_CHUNK 16
+
+static inline void
+float32_gen2_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+               float_status *s, hard_f32_op2_fn hard, soft_f32_op2_fn soft,
+               f32_check_fn pre, f32_check_fn post)
+{
+    while (n) {
+        size_t i, c = MIN(n, HARDFLOAT_CHUNK);
+        union_float32 ur[HARDFLOAT_CHUNK];
+        bool ok = can_use_fpu(s);
+
+        if (ok) {
+            for (i = 0; i < c; i++) {
+                union_float32 ua = { .s = a[i] }, ub = { .s = b[i] };
+
+                ur[i].h = hard(ua.h, ub.h);
+                ok &= pre(ua, ub) & !f32_is_inf(ur[i]) &
+                      !(fabsf(ur[i].h) <= FLT_MIN && post(ua, ub));
+            }
+        }
+        if (likely(ok)) {
+            memcpy(d, ur, c * sizeof(float32));
+        } else {
+            for (i = 0; i < c; i++) {
+                d[i] = float32_gen2(a[i], b[i], s, hard, soft, pre, post);
+            }
+        }
+        d += c;
+        a += c;
+        b += c;
+        n -= c;
+    }
+}
+
+static inline void
+float64_gen2_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+               float_status *s, hard_f64_op2_fn hard, soft_f64_op2_fn soft,
+               f64_check_fn pre, f64_check_fn post)
+{
+    while (n) {
+        size_t i, c = MIN(n, HARDFLOAT_CHUNK);
+        union_float64 ur[HARDFLOAT_CHUNK];
+        bool ok = can_use_fpu(s);
+
+        if (ok) {
+            for (i = 0; i < c; i++) {
+                union_float64 ua = { .s = a[i] }, ub = { .s = b[i] };
+
+                ur[i].h = hard(ua.h, ub.h);
+                ok &= pre(ua, ub) & !f64_is_inf(ur[i]) &
+                      !(fabs(ur[i].h) <= DBL_MIN && post(ua, ub));
+            }
+        }
+        if (likely(ok)) {
+            memcpy(d, ur, c * sizeof(float64));
+        } else {
+            for (i = 0; i < c; i++) {
+                d[i] = float64_gen2(a[i], b[i], s, hard, soft, pre, post);
+            }
+        }
+        d += c;
+        a += c;
+        b += c;
+        n -= c;
+    }
+}
+
 /*
  * Classify a floating point number. Everything above float_class_qnan
  * is a NaN so cls >= float_class_qnan is any NaN.
@@ -2533,6 +2609,66 @@ float64_div(float64 a, float64 b, float_status *s)
                         f64_div_pre, f64_div_post);
 }
 
+/*
+ * Batched addition, subtraction, multiplication and division
+ */
+
+void float32_add_n(float32 *d, const float32 *a, const float32 *b,
+                   size_t n, float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_add, soft_f32_add,
+                   f32_is_zon2, f32_addsubmul_post);
+}
+
+void float32_sub_n(float32 *d, const float32 *a, const float32 *b,
+                   size_t n, float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_sub, soft_f32_sub,
+                   f32_is_zon2, f32_addsubmul_post);
+}
+
+void float32_mul_n(float32 *d, const float32 *a, const float32 *b,
+                   size_t n, float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_mul, soft_f32_mul,
+                   f32_is_zon2, f32_addsubmul_post);
+}
+
+void float32_div_n(float32 *d, const float32 *a, const float32 *b,
+                   size_t n, float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_div, soft_f32_div,
+                   f32_div_pre, f32_div_post);
+}
+
+void float64_add_n(float64 *d, const float64 *a, const float64 *b,
+                   size_t n, float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_add, soft_f64_add,
+                   f64_is_zon2, f64_addsubmul_post);
+}
+
+void float64_sub_n(float64 *d, const float64 *a, const float64 *b,
+                   size_t n, float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_sub, soft_f64_sub,
+                   f64_is_zon2, f64_addsubmul_post);
+}
+
+void float64_mul_n(float64 *d, const float64 *a, const float64 *b,
+                   size_t n, float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_mul, soft_f64_mul,
+                   f64_is_zon2, f64_addsubmul_post);
+}
+
+void float64_div_n(float64 *d, const float64 *a, const float64 *b,
+                   size_t n, float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_div, soft_f64_div,
+                   f64_div_pre, f64_div_post);
+}
+
 float64 float64r32_div(float64 a, float64 b, float_status *status)
 {
     FloatParts64 pa, pb, *pr;
@@ -2825,7 +2961,8 @@ float16 float64_to_float16(float64 a, bool ieee, float_status *s)
     return float16a_round_pack_canonical(&p, s, fmt);
 }
 
-float32 float64_to_float32(float64 a, float_status *s)
+static float32 QEMU_SOFTFLOAT_ATTR
+soft_float64_to_float32(float64 a, float_status *s)
 {
     FloatParts64 p;
 
@@ -2834,6 +2971,26 @@ float32 float64_to_float32(float64 a, float_status *s)
     return float32_round_pack_canonical(&p, s);
 }
 
+float32 float64_to_float32(float64 a, float_status *s)
+{
+    if (can_use_fpu(s) && likely(float64_is_zero_or_normal(a))) {
+        /*
+         * Rounding to nearest-even on the host matches softfloat, and the
+         * inexact flag is already set.  Overflow and underflow must raise
+         * their own flags, so leave them to the soft path.
+         */
+        union_float64 ud = { .s = a };
+        union_float32 uf;
+
+        uf.h = ud.h;
+        if (likely(!f32_is_inf(uf) &&
+                   (fabsf(uf.h) > FLT_MIN || float64_is_zero(a)))) {
+            return uf.s;
+        }
+    }
+    return soft_float64_to_float32(a, s);
+}
+
 float32 bfloat16_to_float32(bfloat16 a, float_status *s)
 {
     FloatParts64 p;
@@ -4279,10 +4436,62 @@ static bfloat16 bfloat16_minmax(bfloat16 a, bfloat16 b,
     return bfloat16_round_pack_canonical(pr, s);
 }
 
+/*
+ * Between two numbers that are zero or normal, and not both zero, the
+ * result is one of the inputs and no flag is raised.  Zeroes of opposite
+ * signs, equal magnitudes with minmax_ismag and NaNs are left to the
+ * soft path.
+ */
+static bool f32_minmax_hard(union_float32 *ua, union_float32 *ub, int flags)
+{
+    float a, b;
+
+    if (QEMU_NO_HARDFLOAT || !f32_is_zon2(*ua, *ub) ||
+        (float32_is_zero(ua->s) && float32_is_zero(ub->s))) {
+        return false;
+    }
+    a = flags & minmax_ismag ? fabsf(ua->h) : ua->h;
+    b = flags & minmax_ismag ? fabsf(ub->h) : ub->h;
+    if (a == b) {
+        return !(flags & minmax_ismag);
+    }
+    if ((a < b) != !!(flags & minmax_ismin)) {
+        *ua = *ub;
+    }
+    return true;
+}
+
+static bool f64_minmax_hard(union_float64 *ua, union_float64 *ub, int flags)
+{
+    double a, b;
+
+    if (QEMU_NO_HARDFLOAT || !f64_is_zon2(*ua, *ub) ||
+        (float64_is_zero(ua->s) && float64_is_zero(ub->s))) {
+        return false;
+    }
+    a = flags & minmax_ismag ? fabs(ua->h) : ua->h;
+    b = flags & minmax_ismag ? fabs(ub->h) : ub->h;
+    if (a == b) {
+        return !(flags & minmax_ismag);
+    }
+    if ((a < b) != !!(flags & minmax_ismin)) {
+        *ua = *ub;
+    }
+    return true;
+}
+
 static float32 float32_minmax(float32 a, float32 b, float_status *s, int flags)
 {
+    union_float32 ua = { .s = a }, ub = { .s = b };
     FloatParts64 pa, pb, *pr;
 
+    float32_input_flush2(&ua.s, &ub.s, s);
+    if (likely(f32_minmax_hard(&ua, &ub, flags))) {
+        return ua.s;
+    }
+    a = ua.s;
+    b = ub.s;
+
     float32_unpack_canonical(&pa, a, s);
     float32_unpack_canonical(&pb, b, s);
     pr = parts_minmax(&pa, &pb, s, flags);
@@ -4292,8 +4501,16 @@ static float32 float32_minmax(float32 a, float32 b, float_status *s, int flags)
 
 static float64 float64_minmax(float64 a, float64 b, float_status *s, int flags)
 {
+    union_float64 ua = { .s = a }, ub = { .s = b };
     FloatParts64 pa, pb, *pr;
 
+    float64_input_flush2(&ua.s, &ub.s, s);
+    if (likely(f64_minmax_hard(&ua, &ub, flags))) {
+        return ua.s;
+    }
+    a = ua.s;
+    b = ub.s;
+
     float64_unpack_canonical(&pa, a, s);
     float64_unpack_canonical(&pb, b, s);
     pr = parts_minmax(&pa, &pb, s, flags);
@@ -1380,48 +1380,32 @@ int virtqueue_avail_bytes(VirtQueue *vq, unsigned int in_bytes,
 static bool virtqueue_map_desc(VirtIODevice *vdev, unsigned int *p_num_sg,
                                hwaddr *addr, struct iovec *iov,
                                unsigned int max_num_sg, bool is_write,
-                               hwaddr pa, size_t sz)
+                               const MemoryMapEntry *desc,
+                               unsigned int num_desc)
 {
-    bool ok = false;
-    unsigned num_sg = *p_num_sg;
-    assert(num_sg <= max_num_sg);
+    dma_addr_t len, total = 0;
+    unsigned int i;
 
-    if (!sz) {
-        virtio_error(vdev, "virtio: zero sized buffers are not allowed");
-        goto out;
+    for (i = 0; i < num_desc; i++) {
+        total += desc[i].len;
     }
 
-    while (sz) {
-        hwaddr len = sz;
-
-        if (num_sg == max_num_sg) {
-            virtio_error(vdev, "virtio: too many write descriptors in "
-                               "indirect table");
-            goto out;
-        }
-
-        iov[num_sg].iov_base = dma_memory_map(vdev->dma_as, pa, &len,
-                                              is_write ?
-                                              DMA_DIRECTION_FROM_DEVICE :
-                                              DMA_DIRECTION_TO_DEVICE,
-                                              MEMTXATTRS_UNSPECIFIED);
-        if (!iov[num_sg].iov_base) {
-            virtio_error(vdev, "virtio: bogus descriptor or out of resources");
-            goto out;
-        }
-
-        iov[num_sg].iov_len = len;
-        addr[num_sg] = pa;
-
-        sz -= len;
-        pa += len;
-        num_sg++;
+    *p_num_sg = dma_memory_map_batch(vdev->dma_as, desc, num_desc, iov, addr,
+                                     max_num_sg, &len,
+                                     is_write ? DMA_DIRECTION_FROM_DEVICE :
+                                     DMA_DIRECTION_TO_DEVICE,
+                                     MEMTXATTRS_UNSPECIFIED);
+    if (len == total) {
+        return true;
     }
-    ok = true;
 
-out:
-    *p_num_sg = num_sg;
-    return ok;
+    if (*p_num_sg == max_num_sg) {
+        virtio_error(vdev, "virtio: too many write descriptors in "
+                           "indirect table");
+    } else {
+        virtio_error(vdev, "virtio: bogus descriptor or out of resources");
+    }
+    return false;
 }
 
 /* Only used by error code paths before we have a VirtQueueElement (therefore
@@ -1505,6 +1489,8 @@ static void *virtqueue_split_pop(VirtQueue *vq, size_t sz)
     VirtIODevice *vdev = vq->vdev;
     VirtQueueElement *elem = NULL;
     unsigned out_num, in_num, elem_entries;
+    unsigned out_desc, in_desc;
+    MemoryMapEntry sg[VIRTQUEUE_MAX_SIZE];
     hwaddr addr[VIRTQUEUE_MAX_SIZE];
     struct iovec iov[VIRTQUEUE_MAX_SIZE];
     VRingDesc desc;
@@ -1522,6 +1508,7 @@ static void *virtqueue_split_pop(VirtQueue *vq, size_t sz)
 
     /* When we start there are none of either input nor output. */
     out_num = in_num = elem_entries = 0;
+    out_desc = in_desc = 0;
 
     max = vq->vring.num;
 
@@ -1575,36 +1562,49 @@ static void *virtqueue_split_pop(VirtQueue *vq, size_t sz)
 
     /* Collect all the descriptors */
     do {
-        bool map_ok;
+        if (!desc.len) {
+            virtio_error(vdev, "virtio: zero sized buffers are not allowed");
+            goto done;
+        }
+        if (out_desc + in_desc == VIRTQUEUE_MAX_SIZE) {
+            virtio_error(vdev, "virtio: too many write descriptors in "
+                               "indirect table");
+            goto done;
+        }
 
         if (desc.flags & VRING_DESC_F_WRITE) {
-            map_ok = virtqueue_map_desc(vdev, &in_num, addr + out_num,
-                                        iov + out_num,
-                                        VIRTQUEUE_MAX_SIZE - out_num, true,
-                                        desc.addr, desc.len);
+            in_desc++;
         } else {
-            if (in_num) {
+            if (in_desc) {
                 virtio_error(vdev, "Incorrect order for descriptors");
-                goto err_undo_map;
+                goto done;
             }
-            map_ok = virtqueue_map_desc(vdev, &out_num, addr, iov,
-                                        VIRTQUEUE_MAX_SIZE, false,
-                                        desc.addr, desc.len);
-        }
-        if (!map_ok) {
-            goto err_undo_map;
+            out_desc++;
         }
+        sg[out_desc + in_desc - 1] = (MemoryMapEntry) {
+            .addr = desc.addr,
+            .len = desc.len,
+        };
 
         /* If we've got too many, that implies a descriptor loop. */
         if (++elem_entries > max) {
             virtio_error(vdev, "Looped descriptor");
-            goto err_undo_map;
+            goto done;
         }
 
         rc = virtqueue_split_read_next_desc(vdev, &desc, desc_cache, max);
     } while (rc == VIRTQUEUE_READ_DESC_MORE);
 
     if (rc == VIRTQUEUE_READ_DESC_ERROR) {
+        goto done;
+    }
+
+    /* Map them all, translating each list in one go */
+    if (!virtqueue_map_desc(vdev, &out_num, addr, iov, VIRTQUEUE_MAX_SIZE,
+                            false, sg, out_desc) ||
+        !virtqueue_map_desc(vdev, &in_num, addr + out_num, iov + out_num,
+                            VIRTQUEUE_MAX_SIZE - out_num, true,
+                            sg + out_desc, in_desc)) {
         goto err_undo_map;
     }
 
@@ -1644,6 +1644,8 @@ static void *virtqueue_packed_pop(VirtQueue *vq, size_t sz)
     VirtIODevice *vdev = vq->vdev;
     VirtQueueElement *elem = NULL;
     unsigned out_num, in_num, elem_entries;
+    unsigned out_desc, in_desc;
+    MemoryMapEntry sg[VIRTQUEUE_MAX_SIZE];
     hwaddr addr[VIRTQUEUE_MAX_SIZE];
     struct iovec iov[VIRTQUEUE_MAX_SIZE];
     VRingPackedDesc desc;
@@ -1659,6 +1661,7 @@ static void *virtqueue_packed_pop(VirtQueue *vq, size_t sz)
 
     /* When we start there are none of either input nor output. */
     out_num = in_num = elem_entries = 0;
+    out_desc = in_desc = 0;
 
     max = vq->vring.num;
 
@@ -1705,30 +1708,34 @@ static void *virtqueue_packed_pop(VirtQueue *vq, size_t sz)
 
     /* Collect all the descriptors */
     do {
-        bool map_ok;
+        if (!desc.len) {
+            virtio_error(vdev, "virtio: zero sized buffers are not allowed");
+            goto done;
+        }
+        if (out_desc + in_desc == VIRTQUEUE_MAX_SIZE) {
+            virtio_error(vdev, "virtio: too many write descriptors in "
+                               "indirect table");
+            goto done;
+        }
 
         if (desc.flags & VRING_DESC_F_WRITE) {
-            map_ok = virtqueue_map_desc(vdev, &in_num, addr + out_num,
-                                        iov + out_num,
-                                        VIRTQUEUE_MAX_SIZE - out_num, true,
-                                        desc.addr, desc.len);
+            in_desc++;
         } else {
-            if (in_num) {
+            if (in_desc) {
                 virtio_error(vdev, "Incorrect order for descriptors");
-                goto err_undo_map;
+                goto done;
             }
-            map_ok = virtqueue_map_desc(vdev, &out_num, addr, iov,
-                                        VIRTQUEUE_MAX_SIZE, false,
-                                        desc.addr, desc.len);
-        }
-        if (!map_ok) {
-            goto err_undo_map;
+            out_desc++;
         }
+        sg[out_desc + in_desc - 1] = (MemoryMapEntry) {
+            .addr = desc.addr,
+            .len = desc.len,
+        };
 
         /* If we've got too many, that implies a descriptor loop. */
         if (++elem_entries > max) {
             virtio_error(vdev, "Looped descriptor");
-            goto err_undo_map;
+            goto done;
         }
 
         rc = virtqueue_packed_read_next_desc(vq, &desc, desc_cache, max, &i,
@@ -1736,6 +1743,15 @@ static void *virtqueue_packed_pop(VirtQueue *vq, size_t sz)
                                              &indirect_desc_cache);
     } while (rc == VIRTQUEUE_READ_DESC_MORE);
 
+    /* Map them all, translating each list in one go */
+    if (!virtqueue_map_desc(vdev, &out_num, addr, iov, VIRTQUEUE_MAX_SIZE,
+                            false, sg, out_desc) ||
+        !virtqueue_map_desc(vdev, &in_num, addr + out_num, iov + out_num,
+                            VIRTQUEUE_MAX_SIZE - out_num, true,
+                            sg + out_desc, in_desc)) {
+        goto err_undo_map;
+    }
+
     /* Now copy what we have collected and mapped */
     elem = virtqueue_alloc_element(sz, out_num, in_num);
     for (i = 0; i < out_num; i++) {
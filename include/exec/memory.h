@@ -2918,6 +2918,49 @@ bool address_space_access_valid(AddressSpace *as, hwaddr addr, hwaddr len,
 void *address_space_map(AddressSpace *as, hwaddr addr,
                         hwaddr *plen, bool is_write, MemTxAttrs attrs);
 
+/**
+ * struct MemoryMapEntry: a range of guest memory for address_space_map_batch()
+ *
+ * @addr: address within the address space
+ * @len: length of the range
+ */
+typedef struct MemoryMapEntry {
+    hwaddr addr;
+    hwaddr len;
+} MemoryMapEntry;
+
+/**
+ * address_space_map_batch: map a scatter-gather list into host iovecs
+ *
+ * Equivalent to calling address_space_map() on each range in turn until
+ * it is mapped completely, but all ranges are translated within a single
+ * RCU critical section, and consecutive ranges that fall in the same RAM
+ * section reuse the previous translation.
+ *
+ * Mapping stops at the first range that cannot be mapped (e.g. because
+ * the bounce buffer is in use), or when @max_iov iovecs have been filled.
+ * The caller can tell by comparing *@plen with the total length of @sg.
+ * Each iovec must be released with address_space_unmap().
+ *
+ * Returns the number of iovecs that were filled.
+ *
+ * @as: #AddressSpace to be accessed
+ * @sg: ranges to map
+ * @nsg: number of entries in @sg
+ * @iov: filled with the host address and length of the mapped memory;
+ *       a range may need more than one iovec
+ * @iov_addr: if not %NULL, filled with the address of each iovec within @as
+ * @max_iov: number of entries in @iov and @iov_addr
+ * @plen: set to the number of bytes that were mapped
+ * @is_write: indicates the transfer direction
+ * @attrs: memory attributes
+ */
+unsigned address_space_map_batch(AddressSpace *as,
+                                 const MemoryMapEntry *sg, unsigned nsg,
+                                 struct iovec *iov, hwaddr *iov_addr,
+                                 unsigned max_iov, hwaddr *plen,
+                                 bool is_write, MemTxAttrs attrs);
+
 /* address_space_unmap: Unmaps a memory region previously mapped by address_space_map()
  *
  * Will also mark the memory as dirty if @is_write == %true.  @access_len gives
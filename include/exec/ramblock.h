@@ -75,6 +75,23 @@ struct RAMBlock {
      * could not have been valid on the source.
      */
     ram_addr_t postcopy_length;
+
+    /*
+     * With mapped-ram, the bitmap of pages present in the migration
+     * file and the file offsets of that bitmap and of the pages area.
+     * Bits are set by the migration thread and multifd channels.
+     */
+    unsigned long *file_bmap;
+    off_t bitmap_offset;
+    uint64_t pages_offset;
+
+    /*
+     * With defer-hot-pages, for each chunk of pages: how often it was
+     * dirtied again after being sent, and whether any page of it was
+     * sent since the last bitmap sync.  Protected by the bitmap mutex.
+     */
+    uint8_t *chunk_heat;
+    unsigned long *chunk_sent;
 };
 #endif
 #endif
@@ -199,8 +199,15 @@ struct CPUClass {
  */
 #define NB_MMU_MODES 16
 
-/* Use a fully associative victim tlb of 8 entries. */
+/*
+ * Use a fully associative victim tlb of 8 entries, which may grow
+ * up to 32 entries for a mmu mode that makes good use of it.
+ */
 #define CPU_VTLB_SIZE 8
+#define CPU_VTLB_MAX_SIZE 32
+
+/* Remember the 4 most recently filled large pages per mmu mode. */
+#define CPU_TLB_LARGE_PAGES 4
 
 /*
  * The full TLB entry, which is not accessed by generated TCG code,
@@ -275,19 +282,46 @@ typedef struct CPUTLBDesc {
      */
     vaddr large_page_addr;
     vaddr large_page_mask;
+    /*
+     * The most recently filled large pages, each described by its
+     * aligned virtual address and by the CPUTLBEntryFull of its first
+     * page.  A miss within one of them is filled from here, without
+     * walking the guest page tables again.  Cleared with the tlb.
+     */
+    size_t lp_index;
+    vaddr lp_vaddr[CPU_TLB_LARGE_PAGES];
+    CPUTLBEntryFull lp_full[CPU_TLB_LARGE_PAGES];
     /* host time (in ns) at the beginning of the time window */
     int64_t window_begin_ns;
     /* maximum number of entries observed in the window */
     size_t window_max_entries;
     size_t n_used_entries;
+    /* victim tlb lookups and hits observed in the window */
+    size_t window_vlookups;
+    size_t window_vhits;
+    /* The number of entries in use in the tlb victim table.  */
+    size_t vsize;
     /* The next index to use in the tlb victim table.  */
     size_t vindex;
     /* The tlb victim table, in two parts.  */
-    CPUTLBEntry vtable[CPU_VTLB_SIZE];
-    CPUTLBEntryFull vfulltlb[CPU_VTLB_SIZE];
+    CPUTLBEntry vtable[CPU_VTLB_MAX_SIZE];
+    CPUTLBEntryFull vfulltlb[CPU_VTLB_MAX_SIZE];
     CPUTLBEntryFull *fulltlb;
 } CPUTLBDesc;
 
+/*
+ * A page or range flush requested by another cpu, which has not been
+ * performed yet.
+ */
+typedef struct CPUTLBPendingFlush {
+    vaddr addr;
+    vaddr len;
+    uint16_t idxmap;
+    uint16_t bits;
+} CPUTLBPendingFlush;
+
+#define CPU_TLB_PENDING_FLUSHES 8
+
 /*
  * Data elements that are shared between all MMU modes.
  */
@@ -300,6 +334,16 @@ typedef struct CPUTLBCommon {
      * Protected by tlb_c.lock.
      */
     uint16_t dirty;
+    /*
+     * Flushes queued by other cpus, performed together by a single work
+     * item.  Adjacent ranges are merged; once the queue overflows, the
+     * mmu_idx in pending_full are flushed entirely instead.
+     * Protected by tlb_c.lock.
+     */
+    bool pending_work;
+    uint16_t pending_full;
+    unsigned int n_pending;
+    CPUTLBPendingFlush pending[CPU_TLB_PENDING_FLUSHES];
     /*
      * Statistics.  These are not lock protected, but are read and
      * written atomically.  This allows the monitor to print a snapshot
@@ -308,6 +352,17 @@ typedef struct CPUTLBCommon {
     size_t full_flush_count;
     size_t part_flush_count;
     size_t elide_flush_count;
+    size_t merge_flush_count;
+    /*
+     * Lookups that missed the main table, and how many of those were
+     * satisfied by the victim table; the rest required a tlb_fill,
+     * which may have been served from the recent large pages.
+     * Hits in the main table are resolved by generated code and are
+     * not counted.
+     */
+    size_t miss_count;
+    size_t victim_hit_count;
+    size_t large_page_fill_count;
 } CPUTLBCommon;
 
 /*
@@ -419,6 +474,8 @@ struct qemu_work_item;
  * @stopped: Indicates the CPU has been artificially stopped.
  * @unplug: Indicates a pending CPU unplug request.
  * @crash_occurred: Indicates the OS reported a crash (panic) for this CPU
+ * @profile_request: Indicates a pending request from the TCG sampling
+ *   profiler to record the guest PC.
  * @singlestep_enabled: Flags for single-stepping.
  * @icount_extra: Instructions until next timer event.
  * @neg.can_do_io: True if memory-mapped IO is allowed.
@@ -448,6 +505,10 @@ struct qemu_work_item;
  *    ring is enabled.
  * @kvm_fetch_index: Keeps the index that we last fetched from the per-vCPU
  *    dirty ring structure.
+ * @kvm_dirty_ring_max_fill: Highest number of entries found in the KVM
+ *    dirty ring when reaping it.
+ * @kvm_dirty_ring_full_exits: Number of exits because the KVM dirty ring
+ *    was full.
  *
  * State of one CPU core or thread.
  *
@@ -482,6 +543,7 @@ struct CPUState {
     bool unplug;
     bool crash_occurred;
     bool exit_request;
+    bool profile_request;
     int exclusive_context_count;
     uint32_t cflags_next_tb;
     /* updates protected by BQL */
@@ -526,6 +588,8 @@ struct CPUState {
     struct kvm_run *kvm_run;
     struct kvm_dirty_gfn *kvm_dirty_gfns;
     uint32_t kvm_fetch_index;
+    uint32_t kvm_dirty_ring_max_fill;
+    uint64_t kvm_dirty_ring_full_exits;
     uint64_t dirty_pages;
     int kvm_vcpu_stats_fd;
 
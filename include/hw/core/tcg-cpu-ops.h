@@ -126,6 +126,17 @@ struct TCGCPUOps {
     bool (*tlb_fill)(CPUState *cpu, vaddr address, int size,
                      MMUAccessType access_type, int mmu_idx,
                      bool probe, uintptr_t retaddr);
+    /**
+     * @tlb_fill_large_pages: Whether the other pages of a large page
+     * may be filled without calling @tlb_fill
+     *
+     * Return true if, in the current configuration, the result of
+     * @tlb_fill for one page of a large page mapped for @mmu_idx also
+     * holds for the other pages it covers.  Targets that check anything
+     * at a finer granule than the large page, such as Arm granule
+     * protection or RISC-V PMP, leave this NULL, which disables it.
+     */
+    bool (*tlb_fill_large_pages)(CPUState *cpu, int mmu_idx);
     /**
      * @do_transaction_failed: Callback for handling failed memory transactions
      * (ie bus faults or external aborts; not MMU faults)
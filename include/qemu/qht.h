@@ -42,6 +42,19 @@ struct qht_stats {
     struct qdist occupancy;
 };
 
+/**
+ * struct qht_lookup_stats - lookup counters, see qht_lookup_custom_stats()
+ * @lookups: number of lookups
+ * @probes: number of buckets visited, including chained ones
+ * @retries: number of times a lookup was restarted because of a
+ *           concurrent update of the bucket
+ */
+struct qht_lookup_stats {
+    size_t lookups;
+    size_t probes;
+    size_t retries;
+};
+
 typedef bool (*qht_lookup_func_t)(const void *obj, const void *userp);
 typedef void (*qht_iter_func_t)(void *p, uint32_t h, void *up);
 typedef bool (*qht_iter_bool_func_t)(void *p, uint32_t h, void *up);
@@ -107,6 +120,22 @@ bool qht_insert(struct qht *ht, void *p, uint32_t hash, void **existing);
 void *qht_lookup_custom(const struct qht *ht, const void *userp, uint32_t hash,
                         qht_lookup_func_t func);
 
+/**
+ * qht_lookup_custom_stats - Look up a pointer and account for the cost
+ * @ht: QHT to be looked up
+ * @userp: pointer to pass to @func
+ * @hash: hash of the pointer to be looked up
+ * @func: function to compare existing pointers against @userp
+ * @stats: counters to update
+ *
+ * Like qht_lookup_custom(), but also updates @stats.  @stats is written
+ * without synchronization, so each thread should use its own; other
+ * threads may read it with qatomic_read().
+ */
+void *qht_lookup_custom_stats(const struct qht *ht, const void *userp,
+                              uint32_t hash, qht_lookup_func_t func,
+                              struct qht_lookup_stats *stats);
+
 /**
  * qht_lookup - Look up a pointer in a QHT
  * @ht: QHT to be looked up
@@ -215,6 +215,37 @@ static inline void *dma_memory_map(AddressSpace *as,
     return p;
 }
 
+/**
+ * dma_memory_map_batch: Map a scatter-gather list into host iovecs.
+ *
+ * See address_space_map_batch().
+ *
+ * @as: #AddressSpace to be accessed
+ * @sg: ranges to map
+ * @nsg: number of entries in @sg
+ * @iov: filled with the host address and length of the mapped memory
+ * @iov_addr: if not %NULL, filled with the address of each iovec within @as
+ * @max_iov: number of entries in @iov and @iov_addr
+ * @len: set to the number of bytes that were mapped
+ * @dir: indicates the transfer direction
+ * @attrs: memory attributes
+ */
+static inline unsigned dma_memory_map_batch(AddressSpace *as,
+                                            const MemoryMapEntry *sg,
+                                            unsigned nsg, struct iovec *iov,
+                                            hwaddr *iov_addr, unsigned max_iov,
+                                            dma_addr_t *len, DMADirection dir,
+                                            MemTxAttrs attrs)
+{
+    hwaddr xlen;
+    unsigned n;
+
+    n = address_space_map_batch(as, sg, nsg, iov, iov_addr, max_iov, &xlen,
+                                dir == DMA_DIRECTION_FROM_DEVICE, attrs);
+    *len = xlen;
+    return n;
+}
+
 /**
  * address_space_unmap: Unmaps a memory region previously mapped
  *                      by dma_memory_map()
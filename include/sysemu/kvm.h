@@ -538,4 +538,12 @@ bool kvm_arch_cpu_check_are_resettable(void);
 bool kvm_dirty_ring_enabled(void);
 
 uint32_t kvm_dirty_ring_size(void);
+
+/**
+ * kvm_dirty_ring_stats:
+ *
+ * Returns: statistics on the use of the KVM dirty rings, or %NULL if
+ * dirty pages are not tracked with dirty rings.
+ */
+struct DirtyRingStats *kvm_dirty_ring_stats(void);
 #endif
@@ -65,6 +65,13 @@ struct KVMDirtyRingReaper {
     QemuThread reaper_thr;
     volatile uint64_t reaper_iteration; /* iteration number of reaper thr */
     volatile enum KVMDirtyRingReaperState reaper_state; /* reap thr state */
+    /*
+     * Helper threads that walk part of the rings when all of them are
+     * reaped; the thread that does the reaping walks the rest.
+     */
+    unsigned int nr_helpers;
+    struct KVMDirtyRingReapHelper *helpers;
+    QemuSemaphore helpers_done;
 };
 struct KVMState
 {
@@ -111,6 +118,7 @@ struct KVMState
     } *as;
     uint64_t kvm_dirty_ring_bytes;  /* Size of the per-vcpu dirty ring */
     uint32_t kvm_dirty_ring_size;   /* Number of dirty GFNs per ring */
+    uint32_t kvm_dirty_ring_reapers; /* Threads reaping all the rings */
     bool kvm_dirty_ring_with_bitmap;
     uint64_t kvm_eager_split_size;  /* Eager Page Splitting chunk size */
     struct KVMDirtyRingReaper reaper;
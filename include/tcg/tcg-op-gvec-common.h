@@ -388,6 +388,55 @@ void tcg_gen_gvec_bitsel(unsigned vece, uint32_t dofs, uint32_t aofs,
                          uint32_t bofs, uint32_t cofs,
                          uint32_t oprsz, uint32_t maxsz);
 
+/*
+ * Permutations.  Elements are numbered from the least significant bits
+ * of each 64-bit unit up, with N = OPRSZ / (1 << VECE).
+ *
+ * zip: interleave elements 0 .. N/2 - 1 of A and B, or N/2 .. N - 1
+ * if HIGH: d[2i] = a[i], d[2i+1] = b[i].
+ * uzp: concatenate the even, or ODD, elements of A and then B.
+ * trn: d[2i] = a[2i], d[2i+1] = b[2i], or with 2i + 1 as the source
+ * element if ODD.
+ */
+void tcg_gen_gvec_zip(unsigned vece, uint32_t dofs, uint32_t aofs,
+                      uint32_t bofs, bool high,
+                      uint32_t oprsz, uint32_t maxsz);
+void tcg_gen_gvec_uzp(unsigned vece, uint32_t dofs, uint32_t aofs,
+                      uint32_t bofs, bool odd,
+                      uint32_t oprsz, uint32_t maxsz);
+void tcg_gen_gvec_trn(unsigned vece, uint32_t dofs, uint32_t aofs,
+                      uint32_t bofs, bool odd,
+                      uint32_t oprsz, uint32_t maxsz);
+
+/*
+ * Widen the elements of size VECE in the low, or HIGH, half of A to
+ * twice their size with sign or zero extension, filling OPRSZ bytes.
+ */
+void tcg_gen_gvec_sxtl(unsigned vece, uint32_t dofs, uint32_t aofs,
+                       bool high, uint32_t oprsz, uint32_t maxsz);
+void tcg_gen_gvec_uxtl(unsigned vece, uint32_t dofs, uint32_t aofs,
+                       bool high, uint32_t oprsz, uint32_t maxsz);
+
+/*
+ * Truncate the elements of A to size VECE, into the low half of D
+ * with the high half zeroed, or into the HIGH half of D with the low
+ * half preserved.
+ */
+void tcg_gen_gvec_xtn(unsigned vece, uint32_t dofs, uint32_t aofs,
+                      bool high, uint32_t oprsz, uint32_t maxsz);
+
+/*
+ * Perform vector dot product: each element of D, four times the size
+ * VECE, is the element of C plus the signed or unsigned products of
+ * the four elements of A and B that it overlaps.
+ */
+void tcg_gen_gvec_sdot(unsigned vece, uint32_t dofs, uint32_t aofs,
+                       uint32_t bofs, uint32_t cofs,
+                       uint32_t oprsz, uint32_t maxsz);
+void tcg_gen_gvec_udot(unsigned vece, uint32_t dofs, uint32_t aofs,
+                       uint32_t bofs, uint32_t cofs,
+                       uint32_t oprsz, uint32_t maxsz);
+
 /*
  * 64-bit vector operations.  Use these when the register has been allocated
  * with tcg_global_mem_new_i64, and so we cannot also address it via pointer.
@@ -413,6 +413,8 @@ typedef struct TCGTemp {
     unsigned int mem_allocated:1;
     unsigned int temp_allocated:1;
     unsigned int temp_subindex:1;
+    /* Global kept in a host register for the whole TB.  */
+    unsigned int pinned:1;
 
     int64_t val;
     struct TCGTemp *mem_base;
@@ -493,12 +495,15 @@ struct TCGContext {
     TCGBar guest_mo;
 
     TCGRegSet reserved_regs;
+    TCGRegSet pinned_regs;        /* home registers of pinned globals */
     intptr_t current_frame_offset;
     intptr_t frame_start;
     intptr_t frame_end;
     TCGTemp *frame_temp;
 
     TranslationBlock *gen_tb;     /* tb for which code is being generated */
+    int gen_nb_succ;              /* direct jump targets of gen_tb */
+    uint64_t gen_succ[2];
     tcg_insn_unit *code_buf;      /* pointer for start of tb */
     tcg_insn_unit *code_ptr;      /* pointer for running end of tb */
 
@@ -557,6 +562,9 @@ struct TCGContext {
        It does not take into account fixed registers */
     TCGTemp *reg_to_temp[TCG_TARGET_NB_REGS];
 
+    /* Tells which pinned global has a given register as its home.  */
+    TCGTemp *pinned_temp[TCG_TARGET_NB_REGS];
+
     uint16_t gen_insn_end_off[TCG_MAX_INSNS];
     uint64_t *gen_insn_data;
 
@@ -578,6 +586,7 @@ extern bool tcg_use_softmmu;
 extern __thread TCGContext *tcg_ctx;
 extern const void *tcg_code_gen_epilogue;
 extern uintptr_t tcg_splitwx_diff;
+extern bool tcg_pin_globals;
 extern TCGv_env tcg_env;
 
 bool in_code_gen_buffer(const void *p);
@@ -18,9 +18,11 @@
  */
 #include "qemu/osdep.h"
 #include "accel/tcg/perf.h"
+#include "accel/tcg/profile.h"
 #include "gdbstub/syscalls.h"
 #include "qemu.h"
 #include "user-internals.h"
+#include "strace.h"
 #include "qemu/plugin.h"
 
 #ifdef CONFIG_GCOV
@@ -35,4 +37,6 @@ void preexit_cleanup(CPUArchState *env, int code)
         gdb_exit(code);
         qemu_plugin_user_exit();
         perf_exit();
+        tcg_profile_exit();
+        print_syscall_stats();
 }
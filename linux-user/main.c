@@ -54,6 +54,7 @@
 #include "signal-common.h"
 #include "loader.h"
 #include "user-mmap.h"
+#include "strace.h"
 #include "accel/tcg/perf.h"
 
 #ifdef CONFIG_SEMIHOSTING
@@ -69,6 +70,8 @@ char *exec_path;
 char real_exec_path[PATH_MAX];
 
 static bool opt_one_insn_per_tb;
+static bool opt_spec_translate;
+static const char *opt_profile;
 static const char *argv0;
 static const char *gdbstub;
 static envlist_t *envlist;
@@ -411,11 +414,26 @@ static void handle_arg_one_insn_per_tb(const char *arg)
     opt_one_insn_per_tb = true;
 }
 
+static void handle_arg_spec_translate(const char *arg)
+{
+    opt_spec_translate = true;
+}
+
+static void handle_arg_profile(const char *arg)
+{
+    opt_profile = arg;
+}
+
 static void handle_arg_strace(const char *arg)
 {
     enable_strace = true;
 }
 
+static void handle_arg_syscall_stats(const char *arg)
+{
+    syscall_stats_enabled = true;
+}
+
 static void handle_arg_version(const char *arg)
 {
     printf("qemu-" TARGET_NAME " version " QEMU_FULL_VERSION
@@ -502,8 +520,16 @@ static const struct qemu_argument arg_table[] = {
      "",           "run with one guest instruction per emulated TB"},
     {"singlestep", "QEMU_SINGLESTEP",  false, handle_arg_one_insn_per_tb,
      "",           "deprecated synonym for -one-insn-per-tb"},
+    {"spec-translate",
+                   "QEMU_SPEC_TRANSLATE", false, handle_arg_spec_translate,
+     "",           "translate likely successors ahead of time"},
+    {"profile",    "QEMU_PROFILE",     true,  handle_arg_profile,
+     "file",       "write a sampled profile of guest code to 'file'"},
     {"strace",     "QEMU_STRACE",      false, handle_arg_strace,
      "",           "log system calls"},
+    {"syscall-stats",
+                   "QEMU_SYSCALL_STATS", false, handle_arg_syscall_stats,
+     "",           "print system call counts and latencies at exit"},
     {"seed",       "QEMU_RAND_SEED",   true,  handle_arg_seed,
      "",           "Seed for pseudo-random number generator"},
     {"trace",      "QEMU_TRACE",       true,  handle_arg_trace,
@@ -791,6 +817,12 @@ int main(int argc, char **argv, char **envp)
         accel_init_interfaces(ac);
         object_property_set_bool(OBJECT(accel), "one-insn-per-tb",
                                  opt_one_insn_per_tb, &error_abort);
+        object_property_set_bool(OBJECT(accel), "spec-translate",
+                                 opt_spec_translate, &error_abort);
+        if (opt_profile) {
+            object_property_set_str(OBJECT(accel), "profile",
+                                    opt_profile, &error_abort);
+        }
         ac->init_machine(NULL);
     }
     cpu = cpu_create(cpu_type);
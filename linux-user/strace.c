@@ -14,6 +14,8 @@
 #include <linux/in6.h>
 #include <linux/netlink.h>
 #include <sched.h>
+#include "qemu/host-utils.h"
+#include "qemu/stats64.h"
 #include "qemu.h"
 #include "user-internals.h"
 #include "strace.h"
@@ -4251,3 +4253,135 @@ void print_taken_signal(int target_signum, const target_siginfo_t *tinfo)
     fprintf(f, " ---\n");
     qemu_log_unlock(f);
 }
+
+/*
+ * Per-syscall counts and latencies, printed at exit like "strace -c".
+ * Slots are allocated on first use, so recording takes no lock.
+ */
+#define SYSCALL_STATS_MAX       8192
+#define SYSCALL_STATS_BUCKETS   40
+
+typedef struct SyscallStats {
+    Stat64 calls;
+    Stat64 errors;
+    Stat64 passthrough;
+    Stat64 total_ns;
+    Stat64 hist[SYSCALL_STATS_BUCKETS];     /* by log2 of the latency in ns */
+} SyscallStats;
+
+bool syscall_stats_enabled;
+static SyscallStats *syscall_stats[SYSCALL_STATS_MAX];
+
+void record_syscall_stats(int num, abi_long ret, int64_t ns, bool passthrough)
+{
+    SyscallStats *st, *old;
+    int bucket;
+
+    if (num < 0 || num >= SYSCALL_STATS_MAX) {
+        return;
+    }
+
+    st = qatomic_rcu_read(&syscall_stats[num]);
+    if (!st) {
+        st = g_new0(SyscallStats, 1);
+        old = qatomic_cmpxchg(&syscall_stats[num], NULL, st);
+        if (old) {
+            g_free(st);
+            st = old;
+        }
+    }
+
+    bucket = ns > 1 ? MIN(63 - clz64(ns), SYSCALL_STATS_BUCKETS - 1) : 0;
+    stat64_add(&st->calls, 1);
+    if (is_error(ret)) {
+        stat64_add(&st->errors, 1);
+    }
+    if (passthrough) {
+        stat64_add(&st->passthrough, 1);
+    }
+    stat64_add(&st->total_ns, ns);
+    stat64_add(&st->hist[bucket], 1);
+}
+
+static const char *syscall_name(int num)
+{
+    int i;
+
+    for (i = 0; i < nsyscalls; i++) {
+        if (scnames[i].nr == num) {
+            return scnames[i].name;
+        }
+    }
+    return NULL;
+}
+
+static gint syscall_stats_cmp(gconstpointer a, gconstpointer b)
+{
+    uint64_t ta = stat64_get(&syscall_stats[*(const int *)a]->total_ns);
+    uint64_t tb = stat64_get(&syscall_stats[*(const int *)b]->total_ns);
+
+    return ta < tb ? 1 : ta > tb ? -1 : 0;
+}
+
+void print_syscall_stats(void)
+{
+    g_autoptr(GArray) nums = g_array_new(false, false, sizeof(int));
+    FILE *f;
+    int i, j;
+
+    if (!syscall_stats_enabled) {
+        return;
+    }
+
+    for (i = 0; i < SYSCALL_STATS_MAX; i++) {
+        if (qatomic_read(&syscall_stats[i])) {
+            g_array_append_val(nums, i);
+        }
+    }
+    g_array_sort(nums, syscall_stats_cmp);
+
+    /*
+     * -syscall-stats does not need a -d mask: without an open log the
+     * report goes to stderr, like "strace -c".
+     */
+    f = qemu_log_trylock();
+    if (!f) {
+        f = stderr;
+    }
+    fprintf(f, "%d %12s %10s %10s %10s %10s  %s\n", getpid(),
+            "usecs", "usecs/call", "calls", "errors", "passthru", "syscall");
+    for (i = 0; i < nums->len; i++) {
+        int num = g_array_index(nums, int, i);
+        SyscallStats *st = syscall_stats[num];
+        uint64_t calls = stat64_get(&st->calls);
+        uint64_t total = stat64_get(&st->total_ns);
+        const char *name = syscall_name(num);
+
+        fprintf(f, "%d %12" PRIu64 " %10" PRIu64 " %10" PRIu64
+                " %10" PRIu64 " %10" PRIu64 "  ", getpid(),
+                total / 1000, total / 1000 / calls, calls,
+                stat64_get(&st->errors), stat64_get(&st->passthrough));
+        if (name) {
+            fprintf(f, "%s\n", name);
+        } else {
+            fprintf(f, "syscall_%d\n", num);
+        }
+
+        /* Latency histogram: lower bound of each bucket in ns, count. */
+        fprintf(f, "%d %12s", getpid(), "");
+        for (j = 0; j < SYSCALL_STATS_BUCKETS; j++) {
+            uint64_t n = stat64_get(&st->hist[j]);
+
+            if (n) {
+                fprintf(f, " %" PRIu64 ":%" PRIu64,
+                        j ? UINT64_C(1) << j : 0, n);
+            }
+        }
+        fprintf(f, "\n");
+    }
+    if (f == stderr) {
+        fflush(f);
+    } else {
+        qemu_log_unlock(f);
+    }
+}
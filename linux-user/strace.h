@@ -24,6 +24,17 @@ void print_syscall(CPUArchState *cpu_env, int num,
 void print_syscall_ret(CPUArchState *cpu_env, int num, abi_long ret,
                        abi_long arg1, abi_long arg2, abi_long arg3,
                        abi_long arg4, abi_long arg5, abi_long arg6);
+
+extern bool syscall_stats_enabled;
+
+/*
+ * Account a syscall that returned @ret after @ns nanoseconds, and was
+ * forwarded to the host as is if @passthrough.
+ */
+void record_syscall_stats(int num, abi_long ret, int64_t ns, bool passthrough);
+/* Print the counts and latencies of all syscalls made so far. */
+void print_syscall_stats(void);
+
 /**
  * print_taken_signal:
  * @target_signum: target signal being taken
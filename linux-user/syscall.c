@@ -138,6 +138,7 @@
 #include "user/safe-syscall.h"
 #include "qemu/guest-random.h"
 #include "qemu/selfmap.h"
+#include "qemu/timer.h"
 #include "user/syscall-trace.h"
 #include "special-errno.h"
 #include "qapi/error.h"
@@ -13626,6 +13627,127 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
     return ret;
 }
 
+/*
+ * When guest and host share the same syscall ABI, syscalls whose
+ * arguments are integers or plain byte buffers need no conversion at
+ * all, and are forwarded to the host straight from this table instead
+ * of going through do_syscall1().  Anything with side effects on the
+ * emulation (memory mappings, signals, threads, fd translation) stays
+ * on the slow path.
+ */
+#if ((defined(TARGET_X86_64) && defined(__x86_64__)) || \
+     (defined(TARGET_AARCH64) && defined(__aarch64__))) && \
+    HOST_BIG_ENDIAN == TARGET_BIG_ENDIAN && !defined(TARGET_ABI32)
+#define SYSCALL_PASSTHROUGH
+
+#define SP_VALID        1
+#define SP_BLOCKING     2   /* may block: use safe_syscall */
+#define SP_BUF_READ     4   /* the host reads the guest buffer */
+#define SP_BUF_WRITE    8   /* the host writes the guest buffer */
+#define SP_FD_TRANS     16  /* data on the fd in arg 0 may need translation */
+
+typedef struct SyscallPassthrough {
+    uint8_t flags;
+    uint8_t buf;        /* argument index of the guest buffer */
+    uint8_t len;        /* argument index of its length */
+} SyscallPassthrough;
+
+#define SP_INT(nr)              [nr] = { SP_VALID }
+#define SP_INT_BLOCKING(nr)     [nr] = { SP_VALID | SP_BLOCKING }
+#define SP_BUF(nr, f, b, l)     [nr] = { SP_VALID | (f), b, l }
+
+static const SyscallPassthrough syscall_passthrough[512] = {
+    SP_BUF(TARGET_NR_read, SP_BLOCKING | SP_BUF_WRITE | SP_FD_TRANS, 1, 2),
+    SP_BUF(TARGET_NR_write, SP_BLOCKING | SP_BUF_READ | SP_FD_TRANS, 1, 2),
+    SP_BUF(TARGET_NR_pread64, SP_BLOCKING | SP_BUF_WRITE, 1, 2),
+    SP_BUF(TARGET_NR_pwrite64, SP_BLOCKING | SP_BUF_READ, 1, 2),
+    SP_BUF(TARGET_NR_getrandom, SP_BLOCKING | SP_BUF_WRITE, 0, 1),
+    SP_INT(TARGET_NR_lseek),
+    SP_INT(TARGET_NR_ftruncate),
+    SP_INT(TARGET_NR_fsync),
+    SP_INT(TARGET_NR_fdatasync),
+    SP_INT(TARGET_NR_syncfs),
+    SP_INT(TARGET_NR_fchmod),
+    SP_INT(TARGET_NR_fchown),
+    SP_INT_BLOCKING(TARGET_NR_flock),
+    SP_INT(TARGET_NR_listen),
+    SP_INT(TARGET_NR_shutdown),
+    SP_INT(TARGET_NR_getpid),
+    SP_INT(TARGET_NR_getppid),
+    SP_INT(TARGET_NR_gettid),
+    SP_INT(TARGET_NR_getpgid),
+    SP_INT(TARGET_NR_setpgid),
+    SP_INT(TARGET_NR_getsid),
+    SP_INT(TARGET_NR_setsid),
+    SP_INT(TARGET_NR_umask),
+    SP_INT(TARGET_NR_sched_yield),
+};
+
+#undef SP_INT
+#undef SP_INT_BLOCKING
+#undef SP_BUF
+
+/*
+ * Forward syscall @num to the host if the table allows it, returning
+ * true with the result in @ret, or false to take the slow path.
+ */
+static bool do_syscall_passthrough(int num, abi_long *ret, abi_long arg1,
+                                   abi_long arg2, abi_long arg3,
+                                   abi_long arg4, abi_long arg5,
+                                   abi_long arg6)
+{
+    long args[6] = { arg1, arg2, arg3, arg4, arg5, arg6 };
+    const SyscallPassthrough *sp;
+    abi_ulong guest_buf = 0;
+    void *p = NULL;
+    long host_ret;
+
+    if (num < 0 || num >= ARRAY_SIZE(syscall_passthrough)) {
+        return false;
+    }
+    sp = &syscall_passthrough[num];
+    if (!(sp->flags & SP_VALID)) {
+        return false;
+    }
+    if ((sp->flags & SP_FD_TRANS) &&
+        (fd_trans_target_to_host_data(arg1) ||
+         fd_trans_host_to_target_data(arg1))) {
+        return false;
+    }
+
+    if (sp->flags & (SP_BUF_READ | SP_BUF_WRITE)) {
+        guest_buf = args[sp->buf];
+        /* Leave NULL buffers and their special cases to the slow path. */
+        if (!guest_buf) {
+            return false;
+        }
+        p = lock_user(sp->flags & SP_BUF_WRITE ? VERIFY_WRITE : VERIFY_READ,
+                      guest_buf, args[sp->len], sp->flags & SP_BUF_READ);
+        if (!p) {
+            *ret = -TARGET_EFAULT;
+            return true;
+        }
+        args[sp->buf] = (long)p;
+    }
+
+    /* Same ABI: the target syscall number is the host one. */
+    if (sp->flags & SP_BLOCKING) {
+        host_ret = safe_syscall(num, args[0], args[1], args[2],
+                                args[3], args[4], args[5]);
+    } else {
+        host_ret = syscall(num, args[0], args[1], args[2],
+                           args[3], args[4], args[5]);
+    }
+    *ret = get_errno(host_ret);
+
+    if (p) {
+        unlock_user(p, guest_buf,
+                    (sp->flags & SP_BUF_WRITE) && *ret > 0 ? *ret : 0);
+    }
+    return true;
+}
+#endif
+
 abi_long do_syscall(CPUArchState *cpu_env, int num, abi_long arg1,
                     abi_long arg2, abi_long arg3, abi_long arg4,
                     abi_long arg5, abi_long arg6, abi_long arg7,
@@ -13633,6 +13755,8 @@ abi_long do_syscall(CPUArchState *cpu_env, int num, abi_long arg1,
 {
     CPUState *cpu = env_cpu(cpu_env);
     abi_long ret;
+    int64_t start = 0;
+    bool passthrough = false;
 
 #ifdef DEBUG_ERESTARTSYS
     /* Debug-only code for exercising the syscall-restart code paths
@@ -13655,8 +13779,22 @@ abi_long do_syscall(CPUArchState *cpu_env, int num, abi_long arg1,
         print_syscall(cpu_env, num, arg1, arg2, arg3, arg4, arg5, arg6);
     }
 
-    ret = do_syscall1(cpu_env, num, arg1, arg2, arg3, arg4,
-                      arg5, arg6, arg7, arg8);
+    if (unlikely(syscall_stats_enabled)) {
+        start = get_clock();
+    }
+
+#ifdef SYSCALL_PASSTHROUGH
+    passthrough = do_syscall_passthrough(num, &ret, arg1, arg2, arg3,
+                                         arg4, arg5, arg6);
+#endif
+    if (!passthrough) {
+        ret = do_syscall1(cpu_env, num, arg1, arg2, arg3, arg4,
+                          arg5, arg6, arg7, arg8);
+    }
+
+    if (unlikely(start)) {
+        record_syscall_stats(num, ret, get_clock() - start, passthrough);
+    }
 
     if (unlikely(qemu_loglevel_mask(LOG_STRACE))) {
         print_syscall_ret(cpu_env, num, ret, arg1, arg2,
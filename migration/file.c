@@ -8,15 +8,21 @@
 #include "qemu/osdep.h"
 #include "qemu/cutils.h"
 #include "qapi/error.h"
+#include "exec/ramblock.h"
 #include "channel.h"
 #include "file.h"
 #include "migration.h"
+#include "options.h"
 #include "io/channel-file.h"
 #include "io/channel-util.h"
 #include "trace.h"
 
 #define OFFSET_OPTION ",offset="
 
+static struct FileOutgoingArgs {
+    char *fname;
+} outgoing_args;
+
 /* Remove the offset option from @filespec and return it in @offsetp. */
 
 int file_parse_offset(char *filespec, uint64_t *offsetp, Error **errp)
@@ -36,6 +42,31 @@ int file_parse_offset(char *filespec, uint64_t *offsetp, Error **errp)
     return 0;
 }
 
+/*
+ * Open one more writer on the outgoing migration file, for a multifd
+ * channel.  All writes happen at fixed offsets, so the channels share
+ * the file without any coordination.
+ */
+QIOChannel *file_send_channel_create(Error **errp)
+{
+    QIOChannelFile *fioc;
+
+    fioc = qio_channel_file_new_path(outgoing_args.fname, O_WRONLY, 0, errp);
+    if (!fioc) {
+        return NULL;
+    }
+    qio_channel_set_name(QIO_CHANNEL(fioc), "migration-file-multifd-outgoing");
+    return QIO_CHANNEL(fioc);
+}
+
+int file_send_channel_destroy(QIOChannel *ioc)
+{
+    object_unref(OBJECT(ioc));
+    g_free(outgoing_args.fname);
+    outgoing_args.fname = NULL;
+    return 0;
+}
+
 void file_start_outgoing_migration(MigrationState *s,
                                    FileMigrationArgs *file_args, Error **errp)
 {
@@ -56,6 +87,15 @@ void file_start_outgoing_migration(MigrationState *s,
     if (offset && qio_channel_io_seek(ioc, offset, SEEK_SET, errp) < 0) {
         return;
     }
+    if (migrate_mapped_ram() &&
+        !qio_channel_has_feature(ioc, QIO_CHANNEL_FEATURE_SEEKABLE)) {
+        error_setg(errp, "Mapped-ram migration requires a seekable file");
+        return;
+    }
+
+    g_free(outgoing_args.fname);
+    outgoing_args.fname = g_strdup(filename);
+
     qio_channel_set_name(ioc, "migration-file-outgoing");
     migration_channel_connect(s, ioc, NULL, NULL);
 }
@@ -74,6 +114,8 @@ void file_start_incoming_migration(FileMigrationArgs *file_args, Error **errp)
     g_autofree char *filename = g_strdup(file_args->filename);
     QIOChannelFile *fioc = NULL;
     uint64_t offset = file_args->offset;
+    int channels = 1;
+    int i;
     QIOChannel *ioc;
 
     trace_migration_file_incoming(filename);
@@ -85,11 +127,114 @@ void file_start_incoming_migration(FileMigrationArgs *file_args, Error **errp)
 
     ioc = QIO_CHANNEL(fioc);
     if (offset && qio_channel_io_seek(ioc, offset, SEEK_SET, errp) < 0) {
+        object_unref(OBJECT(ioc));
         return;
     }
-    qio_channel_set_name(QIO_CHANNEL(ioc), "migration-file-incoming");
-    qio_channel_add_watch_full(ioc, G_IO_IN,
-                               file_accept_incoming_migration,
-                               NULL, NULL,
-                               g_main_context_get_thread_default());
+    if (migrate_mapped_ram() &&
+        !qio_channel_has_feature(ioc, QIO_CHANNEL_FEATURE_SEEKABLE)) {
+        error_setg(errp, "Mapped-ram migration requires a seekable file");
+        object_unref(OBJECT(ioc));
+        return;
+    }
+
+    /*
+     * The main channel must be the first one to be accepted, the
+     * multifd channels only ever read at the offsets it hands out.
+     */
+    if (migrate_multifd()) {
+        channels += migrate_multifd_channels();
+    }
+
+    for (i = 0; i < channels; i++) {
+        if (i) {
+            fioc = qio_channel_file_new_path(filename, O_RDONLY, 0, errp);
+            if (!fioc) {
+                return;
+            }
+            ioc = QIO_CHANNEL(fioc);
+            qio_channel_set_name(ioc, "migration-file-multifd-incoming");
+        } else {
+            qio_channel_set_name(ioc, "migration-file-incoming");
+        }
+        qio_channel_add_watch_full(ioc, G_IO_IN,
+                                   file_accept_incoming_migration,
+                                   NULL, NULL,
+                                   g_main_context_get_thread_default());
+    }
+}
+
+/*
+ * Write the pages described by @iov, which all belong to @block, at
+ * their fixed offsets in the migration file.  Runs of pages that are
+ * contiguous in guest memory are written with a single pwritev().
+ */
+int file_write_ramblock_iov(QIOChannel *ioc, const struct iovec *iov,
+                            int niov, RAMBlock *block, Error **errp)
+{
+    int ret = 0;
+    int i, slice_idx, slice_num;
+    uintptr_t base, next;
+    ram_addr_t offset;
+    size_t len;
+
+    slice_idx = 0;
+    slice_num = 1;
+
+    /*
+     * If the iov array doesn't have contiguous elements, we need to
+     * split it in slices because we only have one file offset for the
+     * whole iov. Do this here so callers don't need to break the iov
+     * array themselves.
+     */
+    for (i = 0; i < niov; i++, slice_num++) {
+        base = (uintptr_t) iov[i].iov_base;
+
+        if (i != niov - 1) {
+            len = iov[i].iov_len;
+            next = (uintptr_t) iov[i + 1].iov_base;
+
+            if (base + len == next) {
+                continue;
+            }
+        }
+
+        /*
+         * Use the offset of the first element of the segment that
+         * we're sending.
+         */
+        offset = (uintptr_t) iov[slice_idx].iov_base - (uintptr_t) block->host;
+        if (offset >= block->used_length) {
+            error_setg(errp, "offset " RAM_ADDR_FMT
+                       " outside of ramblock %s range", offset, block->idstr);
+            ret = -1;
+            break;
+        }
+
+        ret = qio_channel_pwritev_all(ioc, &iov[slice_idx], slice_num,
+                                      block->pages_offset + offset, errp);
+        if (ret < 0) {
+            break;
+        }
+
+        slice_idx += slice_num;
+        slice_num = 0;
+    }
+
+    return ret;
+}
+
+/*
+ * Read @len bytes of @block's pages, starting at @offset within the
+ * block, from their fixed position in the migration file.
+ */
+int file_read_ramblock(QIOChannel *ioc, RAMBlock *block, ram_addr_t offset,
+                       size_t len, Error **errp)
+{
+    struct iovec iov = {
+        .iov_base = block->host + offset,
+        .iov_len = len,
+    };
+
+    return qio_channel_preadv_all(ioc, &iov, 1, block->pages_offset + offset,
+                                  errp);
 }
@@ -113,6 +113,8 @@ void hmp_info_migrate(Monitor *mon, const QDict *qdict)
                        info->ram->normal_bytes >> 10);
         monitor_printf(mon, "dirty sync count: %" PRIu64 "\n",
                        info->ram->dirty_sync_count);
+        monitor_printf(mon, "dirty sync time: %" PRIu64 " us\n",
+                       info->ram->dirty_sync_time);
         monitor_printf(mon, "page size: %" PRIu64 " kbytes\n",
                        info->ram->page_size >> 10);
         monitor_printf(mon, "multifd bytes: %" PRIu64 " kbytes\n",
@@ -201,6 +203,32 @@ void hmp_info_migrate(Monitor *mon, const QDict *qdict)
                        info->dirty_limit_ring_full_time);
     }
 
+    if (info->dirty_ring) {
+        uint8List *fill;
+        uint8_t max_fill = 0;
+
+        for (fill = info->dirty_ring->vcpu_max_fill; fill; fill = fill->next) {
+            max_fill = MAX(max_fill, fill->value);
+        }
+        monitor_printf(mon, "dirty ring: %" PRIu32 " reapers, "
+                       "%" PRIu64 " full exits, max fill %u%%\n",
+                       info->dirty_ring->reapers,
+                       info->dirty_ring->full_exits, max_fill);
+    }
+
+    if (info->multifd_compression) {
+        MultiFDCompressionStatsList *c;
+
+        for (c = info->multifd_compression; c; c = c->next) {
+            monitor_printf(mon, "multifd channel %" PRId64 " compression: "
+                           "pages %" PRId64 ", raw pages %" PRId64 ", "
+                           "rate %0.2f, time %" PRId64 " us\n",
+                           c->value->channel, c->value->pages,
+                           c->value->raw_pages, c->value->compression_rate,
+                           c->value->compression_time);
+        }
+    }
+
     if (info->has_postcopy_blocktime) {
         monitor_printf(mon, "postcopy blocktime: %u\n",
                        info->postcopy_blocktime);
@@ -392,6 +420,22 @@ void hmp_info_migrate_parameters(Monitor *mon, const QDict *qdict)
         monitor_printf(mon, "%s: %s\n",
             MigrationParameter_str(MIGRATION_PARAMETER_MODE),
             qapi_enum_lookup(&MigMode_lookup, params->mode));
+
+        assert(params->has_bitmap_sync_threads);
+        monitor_printf(mon, "%s: %u\n",
+            MigrationParameter_str(MIGRATION_PARAMETER_BITMAP_SYNC_THREADS),
+            params->bitmap_sync_threads);
+
+        assert(params->has_zero_page_detection);
+        monitor_printf(mon, "%s: %s\n",
+            MigrationParameter_str(MIGRATION_PARAMETER_ZERO_PAGE_DETECTION),
+            qapi_enum_lookup(&ZeroPageDetection_lookup,
+                             params->zero_page_detection));
+
+        assert(params->has_postcopy_place_threads);
+        monitor_printf(mon, "%s: %u\n",
+            MigrationParameter_str(MIGRATION_PARAMETER_POSTCOPY_PLACE_THREADS),
+            params->postcopy_place_threads);
     }
 
     qapi_free_MigrationParameters(params);
@@ -679,6 +723,18 @@ void hmp_migrate_set_parameter(Monitor *mon, const QDict *qdict)
         p->has_mode = true;
         visit_type_MigMode(v, param, &p->mode, &err);
         break;
+    case MIGRATION_PARAMETER_BITMAP_SYNC_THREADS:
+        p->has_bitmap_sync_threads = true;
+        visit_type_uint8(v, param, &p->bitmap_sync_threads, &err);
+        break;
+    case MIGRATION_PARAMETER_ZERO_PAGE_DETECTION:
+        p->has_zero_page_detection = true;
+        visit_type_ZeroPageDetection(v, param, &p->zero_page_detection, &err);
+        break;
+    case MIGRATION_PARAMETER_POSTCOPY_PLACE_THREADS:
+        p->has_postcopy_place_threads = true;
+        visit_type_uint8(v, param, &p->postcopy_place_threads, &err);
+        break;
     default:
         assert(0);
     }
@@ -55,6 +55,12 @@ typedef struct {
      * copy.
      */
     Stat64 dirty_sync_missed_zero_copy;
+    /*
+     * Time in microseconds taken by the last synchronization of the
+     * guest bitmaps, and by all of them.
+     */
+    Stat64 dirty_sync_time;
+    Stat64 dirty_sync_time_total;
     /*
      * Number of bytes sent at migration completion stage while the
      * guest is stopped.
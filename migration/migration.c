@@ -66,6 +66,7 @@
 #include "sysemu/qtest.h"
 #include "options.h"
 #include "sysemu/dirtylimit.h"
+#include "sysemu/kvm.h"
 #include "qemu/sockets.h"
 
 static NotifierList migration_state_notifiers =
@@ -146,6 +147,19 @@ migration_channels_and_transport_compatible(MigrationAddress *addr,
         return false;
     }
 
+    if (migrate_mapped_ram() &&
+        addr->transport != MIGRATION_ADDRESS_TYPE_FILE) {
+        error_setg(errp, "Mapped-ram migration requires a file: URI");
+        return false;
+    }
+
+    if (migrate_multifd() && !migrate_mapped_ram() &&
+        addr->transport == MIGRATION_ADDRESS_TYPE_FILE) {
+        error_setg(errp, "Multifd migration to a file requires the"
+                   " mapped-ram capability");
+        return false;
+    }
+
     return true;
 }
 
@@ -1078,6 +1092,9 @@ static void populate_ram_info(MigrationInfo *info, MigrationState *s)
         stat64_get(&mig_stats.dirty_sync_count);
     info->ram->dirty_sync_missed_zero_copy =
         stat64_get(&mig_stats.dirty_sync_missed_zero_copy);
+    info->ram->dirty_sync_time = stat64_get(&mig_stats.dirty_sync_time);
+    info->ram->dirty_sync_time_total =
+        stat64_get(&mig_stats.dirty_sync_time_total);
     info->ram->postcopy_requests =
         stat64_get(&mig_stats.postcopy_requests);
     info->ram->page_size = page_size;
@@ -1119,6 +1136,9 @@ static void populate_ram_info(MigrationInfo *info, MigrationState *s)
         info->has_dirty_limit_ring_full_time = true;
         info->dirty_limit_ring_full_time = dirtylimit_ring_full_time();
     }
+
+    info->dirty_ring = kvm_dirty_ring_stats();
+    info->multifd_compression = multifd_compression_stats();
 }
 
 static void populate_disk_info(MigrationInfo *info)
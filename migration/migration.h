@@ -66,6 +66,8 @@ typedef struct {
     bool all_zero;
 } PostcopyTmpPage;
 
+typedef struct PostcopyPlacer PostcopyPlacer;
+
 typedef enum {
     PREEMPT_THREAD_NONE = 0,
     PREEMPT_THREAD_CREATED,
@@ -156,6 +158,11 @@ struct MigrationIncomingState {
     PostcopyTmpPage *postcopy_tmp_pages;
     /* This is shared for all postcopy channels */
     void     *postcopy_tmp_zero_page;
+    /*
+     * Threads placing the pages of the precopy channel, NULL if they
+     * are placed by the thread that reads them.
+     */
+    PostcopyPlacer *postcopy_placer;
     /* PostCopyFD's for external userfaultfds & handlers of shared memory */
     GArray   *postcopy_remote_fds;
 
@@ -0,0 +1,257 @@
+/*
+ * Multifd lz4 compression implementation
+ *
+ * Unlike zlib and zstd, which compress a whole packet as one stream,
+ * every page is compressed on its own.  LZ4 is fast enough that this
+ * costs little ratio, it lets pages that do not compress be sent as
+ * they are, and it keeps the format simple for offload engines that
+ * work on one page at a time.
+ *
+ * The payload of a packet is an array with the big endian compressed
+ * size of each normal page, followed by the data of each page.  A
+ * size equal to the page size means that the page is sent raw.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include <lz4.h>
+#include "qemu/bswap.h"
+#include "exec/ramblock.h"
+#include "exec/target_page.h"
+#include "qapi/error.h"
+#include "migration.h"
+#include "trace.h"
+#include "options.h"
+#include "multifd.h"
+
+struct lz4_data {
+    /* compression state */
+    void *state;
+    /* sizes of the pages followed by their data */
+    uint8_t *buf;
+    /* size of buf */
+    uint32_t buf_len;
+};
+
+static uint32_t lz4_buf_len(uint32_t page_count, uint32_t page_size)
+{
+    return page_count * (sizeof(uint32_t) + page_size);
+}
+
+/* Multifd lz4 compression */
+
+/**
+ * lz4_send_setup: setup send side
+ *
+ * Allocate the compression state and the buffer for a full packet.
+ *
+ * Returns 0 for success or -1 for error
+ *
+ * @p: Params for the channel that we are using
+ * @errp: pointer to an error
+ */
+static int lz4_send_setup(MultiFDSendParams *p, Error **errp)
+{
+    struct lz4_data *z = g_new0(struct lz4_data, 1);
+
+    z->state = g_try_malloc(LZ4_sizeofState());
+    z->buf_len = lz4_buf_len(p->page_count, p->page_size);
+    z->buf = g_try_malloc(z->buf_len);
+    if (!z->state || !z->buf) {
+        g_free(z->state);
+        g_free(z->buf);
+        g_free(z);
+        error_setg(errp, "multifd %u: out of memory for lz4", p->id);
+        return -1;
+    }
+    p->data = z;
+    return 0;
+}
+
+/**
+ * lz4_send_cleanup: cleanup send side
+ *
+ * Return the memory of the channel.
+ *
+ * @p: Params for the channel that we are using
+ * @errp: pointer to an error
+ */
+static void lz4_send_cleanup(MultiFDSendParams *p, Error **errp)
+{
+    struct lz4_data *z = p->data;
+
+    g_free(z->state);
+    z->state = NULL;
+    g_free(z->buf);
+    z->buf = NULL;
+    g_free(p->data);
+    p->data = NULL;
+}
+
+/**
+ * lz4_send_prepare: prepare date to be able to send
+ *
+ * Compress each page into the buffer, or copy it if it does not get
+ * smaller.
+ *
+ * Returns 0 for success or -1 for error
+ *
+ * @p: Params for the channel that we are using
+ * @errp: pointer to an error
+ */
+static int lz4_send_prepare(MultiFDSendParams *p, Error **errp)
+{
+    struct lz4_data *z = p->data;
+    uint32_t *sizes = (uint32_t *)z->buf;
+    uint32_t out = p->normal_num * sizeof(uint32_t);
+    uint32_t i;
+
+    for (i = 0; i < p->normal_num; i++) {
+        const char *page = (char *)p->pages->block->host + p->normal[i];
+        int len;
+
+        /* Anything that does not fit in less than a page is sent raw */
+        len = LZ4_compress_fast_extState(z->state, page,
+                                         (char *)z->buf + out,
+                                         p->page_size, p->page_size - 1, 1);
+        if (len <= 0) {
+            memcpy(z->buf + out, page, p->page_size);
+            len = p->page_size;
+            p->raw_num++;
+        }
+        stl_be_p(&sizes[i], len);
+        out += len;
+    }
+
+    p->iov[p->iovs_num].iov_base = z->buf;
+    p->iov[p->iovs_num].iov_len = out;
+    p->iovs_num++;
+    p->next_packet_size = out;
+    p->flags |= MULTIFD_FLAG_LZ4;
+
+    return 0;
+}
+
+/**
+ * lz4_recv_setup: setup receive side
+ *
+ * Allocate the buffer for a full packet.
+ *
+ * Returns 0 for success or -1 for error
+ *
+ * @p: Params for the channel that we are using
+ * @errp: pointer to an error
+ */
+static int lz4_recv_setup(MultiFDRecvParams *p, Error **errp)
+{
+    struct lz4_data *z = g_new0(struct lz4_data, 1);
+
+    z->buf_len = lz4_buf_len(p->page_count, p->page_size);
+    z->buf = g_try_malloc(z->buf_len);
+    if (!z->buf) {
+        g_free(z);
+        error_setg(errp, "multifd %u: out of memory for lz4", p->id);
+        return -1;
+    }
+    p->data = z;
+    return 0;
+}
+
+/**
+ * lz4_recv_cleanup: cleanup receive side
+ *
+ * Return the memory of the channel.
+ *
+ * @p: Params for the channel that we are using
+ */
+static void lz4_recv_cleanup(MultiFDRecvParams *p)
+{
+    struct lz4_data *z = p->data;
+
+    g_free(z->buf);
+    z->buf = NULL;
+    g_free(p->data);
+    p->data = NULL;
+}
+
+/**
+ * lz4_recv_pages: read the data from the channel into actual pages
+ *
+ * Read the buffer, and uncompress or copy each page into place.
+ *
+ * Returns 0 for success or -1 for error
+ *
+ * @p: Params for the channel that we are using
+ * @errp: pointer to an error
+ */
+static int lz4_recv_pages(MultiFDRecvParams *p, Error **errp)
+{
+    struct lz4_data *z = p->data;
+    uint32_t in_size = p->next_packet_size;
+    uint32_t flags = p->flags & MULTIFD_FLAG_COMPRESSION_MASK;
+    uint32_t in = p->normal_num * sizeof(uint32_t);
+    uint32_t i;
+    int ret;
+
+    if (flags != MULTIFD_FLAG_LZ4) {
+        error_setg(errp, "multifd %u: flags received %x flags expected %x",
+                   p->id, flags, MULTIFD_FLAG_LZ4);
+        return -1;
+    }
+    if (in_size < in || in_size > z->buf_len) {
+        error_setg(errp, "multifd %u: received packet of size %u for %u pages",
+                   p->id, in_size, p->normal_num);
+        return -1;
+    }
+    ret = qio_channel_read_all(p->c, (void *)z->buf, in_size, errp);
+    if (ret != 0) {
+        return ret;
+    }
+
+    for (i = 0; i < p->normal_num; i++) {
+        uint32_t len = ldl_be_p(z->buf + i * sizeof(uint32_t));
+        char *page = (char *)p->host + p->normal[i];
+
+        if (len > p->page_size || len > in_size - in) {
+            error_setg(errp, "multifd %u: page %u has size %u, "
+                       "%u bytes left", p->id, i, len, in_size - in);
+            return -1;
+        }
+        if (len == p->page_size) {
+            memcpy(page, z->buf + in, len);
+        } else {
+            ret = LZ4_decompress_safe((char *)z->buf + in, page,
+                                      len, p->page_size);
+            if (ret != p->page_size) {
+                error_setg(errp, "multifd %u: lz4 returned %d for page %u",
+                           p->id, ret, i);
+                return -1;
+            }
+        }
+        in += len;
+    }
+    if (in != in_size) {
+        error_setg(errp, "multifd %u: packet size received %u size expected %u",
+                   p->id, in_size, in);
+        return -1;
+    }
+    return 0;
+}
+
+static MultiFDMethods multifd_lz4_ops = {
+    .send_setup = lz4_send_setup,
+    .send_cleanup = lz4_send_cleanup,
+    .send_prepare = lz4_send_prepare,
+    .recv_setup = lz4_recv_setup,
+    .recv_cleanup = lz4_recv_cleanup,
+    .recv_pages = lz4_recv_pages
+};
+
+static void multifd_lz4_register(void)
+{
+    multifd_register_ops(MULTIFD_COMPRESSION_LZ4, &multifd_lz4_ops);
+}
+
+migration_init(multifd_lz4_register);
@@ -11,7 +11,9 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/cutils.h"
 #include "qemu/rcu.h"
+#include "qemu/timer.h"
 #include "exec/target_page.h"
 #include "sysemu/sysemu.h"
 #include "exec/ramblock.h"
@@ -21,6 +23,7 @@
 #include "migration.h"
 #include "migration-stats.h"
 #include "socket.h"
+#include "file.h"
 #include "tls.h"
 #include "qemu-file.h"
 #include "trace.h"
@@ -265,6 +268,7 @@ static void multifd_send_fill_packet(MultiFDSendParams *p)
     packet->flags = cpu_to_be32(p->flags);
     packet->pages_alloc = cpu_to_be32(p->pages->allocated);
     packet->normal_pages = cpu_to_be32(p->normal_num);
+    packet->zero_pages = cpu_to_be32(p->zero_num);
     packet->next_packet_size = cpu_to_be32(p->next_packet_size);
     packet->packet_num = cpu_to_be64(p->packet_num);
 
@@ -278,6 +282,12 @@ static void multifd_send_fill_packet(MultiFDSendParams *p)
 
         packet->offset[i] = cpu_to_be64(temp);
     }
+
+    for (i = 0; i < p->zero_num; i++) {
+        uint64_t temp = p->zero[i];
+
+        packet->offset[p->normal_num + i] = cpu_to_be64(temp);
+    }
 }
 
 static int multifd_recv_unfill_packet(MultiFDRecvParams *p, Error **errp)
@@ -323,10 +333,18 @@ static int multifd_recv_unfill_packet(MultiFDRecvParams *p, Error **errp)
         return -1;
     }
 
+    p->zero_num = be32_to_cpu(packet->zero_pages);
+    if (p->zero_num > packet->pages_alloc - p->normal_num) {
+        error_setg(errp, "multifd: received packet "
+                   "with %u zero pages and expected maximum zero pages are %u",
+                   p->zero_num, packet->pages_alloc - p->normal_num) ;
+        return -1;
+    }
+
     p->next_packet_size = be32_to_cpu(packet->next_packet_size);
     p->packet_num = be64_to_cpu(packet->packet_num);
 
-    if (p->normal_num == 0) {
+    if (p->normal_num == 0 && p->zero_num == 0) {
         return 0;
     }
 
@@ -352,9 +370,87 @@ static int multifd_recv_unfill_packet(MultiFDRecvParams *p, Error **errp)
         p->normal[i] = offset;
     }
 
+    for (i = 0; i < p->zero_num; i++) {
+        uint64_t offset = be64_to_cpu(packet->offset[p->normal_num + i]);
+
+        if (offset > (p->block->used_length - p->page_size)) {
+            error_setg(errp, "multifd: offset too long %" PRIu64
+                       " (max " RAM_ADDR_FMT ")",
+                       offset, p->block->used_length);
+            return -1;
+        }
+        p->zero[i] = offset;
+    }
+
     return 0;
 }
 
+/*
+ * Compression statistics of each send channel.  They outlive the
+ * channels, so that query-migrate still reports them once migration
+ * has completed.
+ */
+typedef struct {
+    Stat64 pages;
+    Stat64 raw_pages;
+    Stat64 compressed_bytes;
+    Stat64 time_us;
+} MultiFDCompressionCounters;
+
+static struct {
+    int channels;
+    MultiFDCompressionCounters *channel;
+} multifd_compression_counters;
+
+static void multifd_compression_counters_reset(int channels)
+{
+    g_free(multifd_compression_counters.channel);
+    multifd_compression_counters.channel =
+        g_new0(MultiFDCompressionCounters, channels);
+    multifd_compression_counters.channels = channels;
+}
+
+static void multifd_compression_account(MultiFDSendParams *p,
+                                        int64_t time_us)
+{
+    MultiFDCompressionCounters *c;
+
+    if (!multifd_compression_counters.channels) {
+        return;
+    }
+    c = &multifd_compression_counters.channel[p->id];
+    stat64_add(&c->pages, p->normal_num);
+    stat64_add(&c->raw_pages, p->raw_num);
+    stat64_add(&c->compressed_bytes, p->next_packet_size);
+    stat64_add(&c->time_us, time_us);
+}
+
+MultiFDCompressionStatsList *multifd_compression_stats(void)
+{
+    MultiFDCompressionStatsList *head = NULL, **tail = &head;
+    int i;
+
+    for (i = 0; i < multifd_compression_counters.channels; i++) {
+        MultiFDCompressionCounters *c;
+        MultiFDCompressionStats *s = g_new0(MultiFDCompressionStats, 1);
+
+        c = &multifd_compression_counters.channel[i];
+
+        s->channel = i;
+        s->pages = stat64_get(&c->pages);
+        s->raw_pages = stat64_get(&c->raw_pages);
+        s->compressed_size = stat64_get(&c->compressed_bytes);
+        s->compression_time = stat64_get(&c->time_us);
+        if (s->compressed_size) {
+            s->compression_rate = (double)s->pages * qemu_target_page_size() /
+                                  s->compressed_size;
+        }
+        QAPI_LIST_APPEND(tail, s);
+    }
+
+    return head;
+}
+
 struct {
     MultiFDSendParams *params;
     /* array of pages to sent */
@@ -511,6 +607,9 @@ static void multifd_send_terminate_threads(Error *err)
 
 static int multifd_send_channel_destroy(QIOChannel *send)
 {
+    if (migrate_mapped_ram()) {
+        return file_send_channel_destroy(send);
+    }
     return socket_send_channel_destroy(send);
 }
 
@@ -552,6 +651,8 @@ void multifd_save_cleanup(void)
         p->iov = NULL;
         g_free(p->normal);
         p->normal = NULL;
+        g_free(p->zero);
+        p->zero = NULL;
         multifd_send_state->ops->send_cleanup(p, &local_err);
         if (local_err) {
             migrate_set_error(migrate_get_current(), local_err);
@@ -647,6 +748,61 @@ int multifd_send_sync_main(QEMUFile *f)
     return 0;
 }
 
+/*
+ * Write the pages prepared in p->iov at their offsets in the mapped-ram
+ * file and record them in the block's file bitmap.
+ */
+static int multifd_send_file_pages(MultiFDSendParams *p, RAMBlock *block,
+                                   Error **errp)
+{
+    /* Zero pages are not written, the loader leaves them untouched */
+    for (int i = 0; i < p->zero_num; i++) {
+        ramblock_set_file_bmap_atomic(block, p->zero[i], false);
+    }
+
+    if (!p->normal_num) {
+        return 0;
+    }
+
+    if (file_write_ramblock_iov(p->c, p->iov, p->iovs_num, block, errp) < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < p->normal_num; i++) {
+        ramblock_set_file_bmap_atomic(block, p->normal[i], true);
+    }
+    stat64_add(&mig_stats.multifd_bytes, p->next_packet_size);
+    return 0;
+}
+
+/*
+ * Split the queued pages into normal and zero pages.  Doing it here
+ * rather than in the migration thread spreads the cost of scanning
+ * the pages over all the channels.
+ */
+static void multifd_send_zero_page_detect(MultiFDSendParams *p)
+{
+    MultiFDPages_t *pages = p->pages;
+    bool detect = migrate_zero_page_detection() == ZERO_PAGE_DETECTION_MULTIFD;
+
+    p->normal_num = 0;
+    p->zero_num = 0;
+
+    for (int i = 0; i < pages->num; i++) {
+        ram_addr_t offset = pages->offset[i];
+
+        if (detect && buffer_is_zero(pages->block->host + offset,
+                                     p->page_size)) {
+            p->zero[p->zero_num++] = offset;
+        } else {
+            p->normal[p->normal_num++] = offset;
+        }
+    }
+
+    stat64_add(&mig_stats.normal_pages, p->normal_num);
+    stat64_add(&mig_stats.zero_pages, p->zero_num);
+}
+
 static void *multifd_send_thread(void *opaque)
 {
     MultiFDSendParams *p = opaque;
@@ -654,18 +810,22 @@ static void *multifd_send_thread(void *opaque)
     Error *local_err = NULL;
     int ret = 0;
     bool use_zero_copy_send = migrate_zero_copy_send();
+    bool use_mapped_ram = migrate_mapped_ram();
 
     thread = migration_threads_add(p->name, qemu_get_thread_id());
 
     trace_multifd_send_thread_start(p->id);
     rcu_register_thread();
 
-    if (multifd_send_initial_packet(p, &local_err) < 0) {
-        ret = -1;
-        goto out;
+    /* With mapped-ram there are no packets, pages go straight to the file */
+    if (!use_mapped_ram) {
+        if (multifd_send_initial_packet(p, &local_err) < 0) {
+            ret = -1;
+            goto out;
+        }
+        /* initial packet */
+        p->num_packets = 1;
     }
-    /* initial packet */
-    p->num_packets = 1;
 
     while (true) {
         qemu_sem_post(&multifd_send_state->channels_ready);
@@ -678,60 +838,73 @@ static void *multifd_send_thread(void *opaque)
 
         if (p->pending_job) {
             uint64_t packet_num = p->packet_num;
+            RAMBlock *block = p->pages->block;
             uint32_t flags;
-            p->normal_num = 0;
 
-            if (use_zero_copy_send) {
+            if (use_zero_copy_send || use_mapped_ram) {
                 p->iovs_num = 0;
             } else {
                 p->iovs_num = 1;
             }
 
-            for (int i = 0; i < p->pages->num; i++) {
-                p->normal[p->normal_num] = p->pages->offset[i];
-                p->normal_num++;
-            }
+            multifd_send_zero_page_detect(p);
 
             if (p->normal_num) {
+                int64_t start = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
+
+                p->raw_num = 0;
                 ret = multifd_send_state->ops->send_prepare(p, &local_err);
                 if (ret != 0) {
                     qemu_mutex_unlock(&p->mutex);
                     break;
                 }
+                multifd_compression_account(p,
+                    qemu_clock_get_us(QEMU_CLOCK_REALTIME) - start);
+            }
+            if (!use_mapped_ram) {
+                multifd_send_fill_packet(p);
             }
-            multifd_send_fill_packet(p);
             flags = p->flags;
             p->flags = 0;
             p->num_packets++;
             p->total_normal_pages += p->normal_num;
+            p->total_zero_pages += p->zero_num;
             p->pages->num = 0;
             p->pages->block = NULL;
             qemu_mutex_unlock(&p->mutex);
 
-            trace_multifd_send(p->id, packet_num, p->normal_num, flags,
-                               p->next_packet_size);
+            trace_multifd_send(p->id, packet_num, p->normal_num, p->zero_num,
+                               flags, p->next_packet_size);
 
-            if (use_zero_copy_send) {
-                /* Send header first, without zerocopy */
-                ret = qio_channel_write_all(p->c, (void *)p->packet,
-                                            p->packet_len, &local_err);
+            if (use_mapped_ram) {
+                ret = multifd_send_file_pages(p, block, &local_err);
                 if (ret != 0) {
                     break;
                 }
             } else {
-                /* Send header using the same writev call */
-                p->iov[0].iov_len = p->packet_len;
-                p->iov[0].iov_base = p->packet;
-            }
+                if (use_zero_copy_send) {
+                    /* Send header first, without zerocopy */
+                    ret = qio_channel_write_all(p->c, (void *)p->packet,
+                                                p->packet_len, &local_err);
+                    if (ret != 0) {
+                        break;
+                    }
+                } else {
+                    /* Send header using the same writev call */
+                    p->iov[0].iov_len = p->packet_len;
+                    p->iov[0].iov_base = p->packet;
+                }
 
-            ret = qio_channel_writev_full_all(p->c, p->iov, p->iovs_num, NULL,
-                                              0, p->write_flags, &local_err);
-            if (ret != 0) {
-                break;
-            }
+                ret = qio_channel_writev_full_all(p->c, p->iov, p->iovs_num,
+                                                  NULL, 0, p->write_flags,
+                                                  &local_err);
+                if (ret != 0) {
+                    break;
+                }
 
-            stat64_add(&mig_stats.multifd_bytes,
-                       p->next_packet_size + p->packet_len);
+                stat64_add(&mig_stats.multifd_bytes,
+                           p->next_packet_size + p->packet_len);
+            }
             p->next_packet_size = 0;
             qemu_mutex_lock(&p->mutex);
             p->pending_job--;
@@ -762,7 +935,8 @@ out:
 
     rcu_unregister_thread();
     migration_threads_remove(thread);
-    trace_multifd_send_thread_end(p->id, p->num_packets, p->total_normal_pages);
+    trace_multifd_send_thread_end(p->id, p->num_packets, p->total_normal_pages,
+                                  p->total_zero_pages);
 
     return NULL;
 }
@@ -894,8 +1068,28 @@ static void multifd_new_send_channel_async(QIOTask *task, gpointer opaque)
     multifd_new_send_channel_cleanup(p, ioc, local_err);
 }
 
+static void multifd_new_file_channel_create(MultiFDSendParams *p)
+{
+    Error *local_err = NULL;
+    QIOChannel *ioc = file_send_channel_create(&local_err);
+
+    if (ioc) {
+        p->running = true;
+        if (multifd_channel_connect(p, ioc, &local_err)) {
+            return;
+        }
+    }
+
+    trace_multifd_new_send_channel_async_error(p->id, local_err);
+    multifd_new_send_channel_cleanup(p, ioc, local_err);
+}
+
 static void multifd_new_send_channel_create(gpointer opaque)
 {
+    if (migrate_mapped_ram()) {
+        multifd_new_file_channel_create(opaque);
+        return;
+    }
     socket_send_channel_create(multifd_new_send_channel_async, opaque);
 }
 
@@ -905,6 +1099,13 @@ int multifd_save_setup(Error **errp)
     uint32_t page_count = MULTIFD_PACKET_SIZE / qemu_target_page_size();
     uint8_t i;
 
+    if (!migrate_multifd() ||
+        migrate_multifd_compression() == MULTIFD_COMPRESSION_NONE) {
+        multifd_compression_counters_reset(0);
+    } else {
+        multifd_compression_counters_reset(migrate_multifd_channels());
+    }
+
     if (!migrate_multifd()) {
         return 0;
     }
@@ -936,6 +1137,7 @@ int multifd_save_setup(Error **errp)
         /* We need one extra place for the packet header */
         p->iov = g_new0(struct iovec, page_count + 1);
         p->normal = g_new0(ram_addr_t, page_count);
+        p->zero = g_new0(ram_addr_t, page_count);
         p->page_size = qemu_target_page_size();
         p->page_count = page_count;
 
@@ -968,6 +1170,10 @@ struct {
     int count;
     /* syncs main thread and channels */
     QemuSemaphore sem_sync;
+    /* mapped-ram: recv channels ready for a new range of pages */
+    QemuSemaphore channels_ready;
+    /* the channels have been told to quit, possibly after an error */
+    bool exiting;
     /* global number of generated multifd packets */
     uint64_t packet_num;
     /* multifd ops */
@@ -981,20 +1187,22 @@ static void multifd_recv_terminate_threads(Error *err)
     trace_multifd_recv_terminate_threads(err != NULL);
 
     if (err) {
-        MigrationState *s = migrate_get_current();
-        migrate_set_error(s, err);
-        if (s->state == MIGRATION_STATUS_SETUP ||
-            s->state == MIGRATION_STATUS_ACTIVE) {
-            migrate_set_state(&s->state, s->state,
-                              MIGRATION_STATUS_FAILED);
-        }
+        MigrationIncomingState *mis = migration_incoming_get_current();
+
+        error_report_err(error_copy(err));
+        migrate_set_state(&mis->state, MIGRATION_STATUS_ACTIVE,
+                          MIGRATION_STATUS_FAILED);
     }
 
+    /* Must be visible before the channels wake up the main thread */
+    qatomic_set(&multifd_recv_state->exiting, true);
+
     for (i = 0; i < migrate_multifd_channels(); i++) {
         MultiFDRecvParams *p = &multifd_recv_state->params[i];
 
         qemu_mutex_lock(&p->mutex);
         p->quit = true;
+        qemu_sem_post(&p->sem);
         /*
          * We could arrive here for two reasons:
          *  - normal quit, i.e. everything went fine, just finished
@@ -1044,6 +1252,7 @@ void multifd_load_cleanup(void)
         p->c = NULL;
         qemu_mutex_destroy(&p->mutex);
         qemu_sem_destroy(&p->sem_sync);
+        qemu_sem_destroy(&p->sem);
         g_free(p->name);
         p->name = NULL;
         p->packet_len = 0;
@@ -1053,21 +1262,68 @@ void multifd_load_cleanup(void)
         p->iov = NULL;
         g_free(p->normal);
         p->normal = NULL;
+        g_free(p->zero);
+        p->zero = NULL;
         multifd_recv_state->ops->recv_cleanup(p);
     }
     qemu_sem_destroy(&multifd_recv_state->sem_sync);
+    qemu_sem_destroy(&multifd_recv_state->channels_ready);
     g_free(multifd_recv_state->params);
     multifd_recv_state->params = NULL;
     g_free(multifd_recv_state);
     multifd_recv_state = NULL;
 }
 
-void multifd_recv_sync_main(void)
+/*
+ * With mapped-ram there is no stream to carry sync packets: ask every
+ * channel to report once it has finished the ranges queued so far.
+ *
+ * Returns 0 once all the ranges are loaded, -1 if a channel failed or
+ * quit, in which case some of them may be missing.
+ */
+static int multifd_recv_file_sync_main(void)
+{
+    int i;
+
+    if (qatomic_read(&multifd_recv_state->exiting)) {
+        return -1;
+    }
+    for (i = 0; i < migrate_multifd_channels(); i++) {
+        MultiFDRecvParams *p = &multifd_recv_state->params[i];
+
+        WITH_QEMU_LOCK_GUARD(&p->mutex) {
+            p->pending_sync = true;
+        }
+        qemu_sem_post(&p->sem);
+    }
+    for (i = 0; i < migrate_multifd_channels(); i++) {
+        MultiFDRecvParams *p = &multifd_recv_state->params[i];
+
+        trace_multifd_recv_sync_main_wait(p->id);
+        qemu_sem_wait(&multifd_recv_state->sem_sync);
+    }
+    for (i = 0; i < migrate_multifd_channels(); i++) {
+        MultiFDRecvParams *p = &multifd_recv_state->params[i];
+
+        trace_multifd_recv_sync_main_signal(p->id);
+        qemu_sem_post(&p->sem_sync);
+    }
+    return qatomic_read(&multifd_recv_state->exiting) ? -1 : 0;
+}
+
+/*
+ * Returns 0 on success, -1 if the pages sent so far could not all be
+ * loaded.
+ */
+int multifd_recv_sync_main(void)
 {
     int i;
 
     if (!migrate_multifd()) {
-        return;
+        return 0;
+    }
+    if (migrate_mapped_ram()) {
+        return multifd_recv_file_sync_main();
     }
     for (i = 0; i < migrate_multifd_channels(); i++) {
         MultiFDRecvParams *p = &multifd_recv_state->params[i];
@@ -1087,6 +1343,93 @@ void multifd_recv_sync_main(void)
         qemu_sem_post(&p->sem_sync);
     }
     trace_multifd_recv_sync_main(multifd_recv_state->packet_num);
+    return 0;
+}
+
+/*
+ * Hand the next @len bytes of pages of @block, starting at @offset, to
+ * an idle channel, which reads them from their fixed position in the
+ * migration file straight into guest memory.
+ *
+ * Returns 0 on success, -1 if the channels are gone.
+ */
+int multifd_recv_queue_file_pages(RAMBlock *block, ram_addr_t offset,
+                                  size_t len)
+{
+    static int next_channel;
+    MultiFDRecvParams *p = NULL;
+    int i;
+
+    qemu_sem_wait(&multifd_recv_state->channels_ready);
+    if (qatomic_read(&multifd_recv_state->exiting)) {
+        return -1;
+    }
+    next_channel %= migrate_multifd_channels();
+    for (i = next_channel;; i = (i + 1) % migrate_multifd_channels()) {
+        p = &multifd_recv_state->params[i];
+
+        qemu_mutex_lock(&p->mutex);
+        if (p->quit) {
+            error_report("%s: channel %d has already quit!", __func__, i);
+            qemu_mutex_unlock(&p->mutex);
+            return -1;
+        }
+        if (!p->pending_job) {
+            next_channel = (i + 1) % migrate_multifd_channels();
+            break;
+        }
+        qemu_mutex_unlock(&p->mutex);
+    }
+
+    p->pending_job = true;
+    p->block = block;
+    p->file_offset = offset;
+    p->file_len = len;
+    qemu_mutex_unlock(&p->mutex);
+    qemu_sem_post(&p->sem);
+
+    return 0;
+}
+
+static int multifd_recv_file_loop(MultiFDRecvParams *p, Error **errp)
+{
+    while (true) {
+        bool job, sync;
+
+        qemu_sem_wait(&p->sem);
+
+        qemu_mutex_lock(&p->mutex);
+        if (p->quit) {
+            qemu_mutex_unlock(&p->mutex);
+            return 0;
+        }
+        job = p->pending_job;
+        sync = p->pending_sync;
+        p->pending_sync = false;
+        qemu_mutex_unlock(&p->mutex);
+
+        if (job) {
+            if (file_read_ramblock(p->c, p->block, p->file_offset,
+                                   p->file_len, errp) < 0) {
+                return -1;
+            }
+            p->num_packets++;
+            p->total_normal_pages += p->file_len / p->page_size;
+            trace_multifd_recv(p->id, p->num_packets,
+                               p->file_len / p->page_size, 0, 0,
+                               p->file_len);
+
+            qemu_mutex_lock(&p->mutex);
+            p->pending_job = false;
+            qemu_mutex_unlock(&p->mutex);
+            qemu_sem_post(&multifd_recv_state->channels_ready);
+        }
+
+        if (sync) {
+            qemu_sem_post(&multifd_recv_state->sem_sync);
+            qemu_sem_wait(&p->sem_sync);
+        }
+    }
 }
 
 static void *multifd_recv_thread(void *opaque)
@@ -1098,6 +1441,23 @@ static void *multifd_recv_thread(void *opaque)
     trace_multifd_recv_thread_start(p->id);
     rcu_register_thread();
 
+    if (migrate_mapped_ram()) {
+        qemu_sem_post(&multifd_recv_state->channels_ready);
+        if (multifd_recv_file_loop(p, &local_err) < 0) {
+            multifd_recv_terminate_threads(local_err);
+            error_free(local_err);
+            local_err = NULL;
+        }
+        /*
+         * Whatever the reason for leaving, don't leave the main thread
+         * waiting for this channel.  It finds multifd_recv_state->exiting
+         * set when it wakes up.
+         */
+        qemu_sem_post(&multifd_recv_state->channels_ready);
+        qemu_sem_post(&multifd_recv_state->sem_sync);
+        goto out;
+    }
+
     while (true) {
         uint32_t flags;
 
@@ -1121,10 +1481,11 @@ static void *multifd_recv_thread(void *opaque)
         flags = p->flags;
         /* recv methods don't know how to handle the SYNC flag */
         p->flags &= ~MULTIFD_FLAG_SYNC;
-        trace_multifd_recv(p->id, p->packet_num, p->normal_num, flags,
-                           p->next_packet_size);
+        trace_multifd_recv(p->id, p->packet_num, p->normal_num, p->zero_num,
+                           flags, p->next_packet_size);
         p->num_packets++;
         p->total_normal_pages += p->normal_num;
+        p->total_zero_pages += p->zero_num;
         qemu_mutex_unlock(&p->mutex);
 
         if (p->normal_num) {
@@ -1134,12 +1495,17 @@ static void *multifd_recv_thread(void *opaque)
             }
         }
 
+        for (int i = 0; i < p->zero_num; i++) {
+            ram_handle_zero(p->host + p->zero[i], p->page_size);
+        }
+
         if (flags & MULTIFD_FLAG_SYNC) {
             qemu_sem_post(&multifd_recv_state->sem_sync);
             qemu_sem_wait(&p->sem_sync);
         }
     }
 
+out:
     if (local_err) {
         multifd_recv_terminate_threads(local_err);
         error_free(local_err);
@@ -1149,7 +1515,8 @@ static void *multifd_recv_thread(void *opaque)
     qemu_mutex_unlock(&p->mutex);
 
     rcu_unregister_thread();
-    trace_multifd_recv_thread_end(p->id, p->num_packets, p->total_normal_pages);
+    trace_multifd_recv_thread_end(p->id, p->num_packets, p->total_normal_pages,
+                                  p->total_zero_pages);
 
     return NULL;
 }
@@ -1173,6 +1540,7 @@ int multifd_load_setup(Error **errp)
     multifd_recv_state->params = g_new0(MultiFDRecvParams, thread_count);
     qatomic_set(&multifd_recv_state->count, 0);
     qemu_sem_init(&multifd_recv_state->sem_sync, 0);
+    qemu_sem_init(&multifd_recv_state->channels_ready, 0);
     multifd_recv_state->ops = multifd_ops[migrate_multifd_compression()];
 
     for (i = 0; i < thread_count; i++) {
@@ -1180,6 +1548,7 @@ int multifd_load_setup(Error **errp)
 
         qemu_mutex_init(&p->mutex);
         qemu_sem_init(&p->sem_sync, 0);
+        qemu_sem_init(&p->sem, 0);
         p->quit = false;
         p->id = i;
         p->packet_len = sizeof(MultiFDPacket_t)
@@ -1188,6 +1557,7 @@ int multifd_load_setup(Error **errp)
         p->name = g_strdup_printf("multifdrecv_%d", i);
         p->iov = g_new0(struct iovec, page_count);
         p->normal = g_new0(ram_addr_t, page_count);
+        p->zero = g_new0(ram_addr_t, page_count);
         p->page_count = page_count;
         p->page_size = qemu_target_page_size();
     }
@@ -1232,7 +1602,15 @@ void multifd_recv_new_channel(QIOChannel *ioc, Error **errp)
     Error *local_err = NULL;
     int id;
 
-    id = multifd_recv_initial_packet(ioc, &local_err);
+    if (migrate_mapped_ram()) {
+        /*
+         * All channels read the same file, there is no handshake and
+         * they are numbered in the order they were opened.
+         */
+        id = qatomic_read(&multifd_recv_state->count);
+    } else {
+        id = multifd_recv_initial_packet(ioc, &local_err);
+    }
     if (id < 0) {
         multifd_recv_terminate_threads(local_err);
         error_propagate_prepend(errp, local_err,
@@ -36,6 +36,9 @@
 
 #define MAX_THROTTLE  (128 << 20)      /* Migration transfer speed throttling */
 
+#define MAX_BITMAP_SYNC_THREADS 64
+#define MAX_POSTCOPY_PLACE_THREADS 64
+
 /* Time in milliseconds we are allowed to stop the source,
  * for sending the last part */
 #define DEFAULT_MIGRATE_SET_DOWNTIME 300
@@ -59,6 +62,8 @@
 /* The delay time (in ms) between two COLO checkpoints */
 #define DEFAULT_MIGRATE_X_CHECKPOINT_DELAY (200 * 100)
 #define DEFAULT_MIGRATE_MULTIFD_CHANNELS 2
+#define DEFAULT_MIGRATE_BITMAP_SYNC_THREADS 1
+#define DEFAULT_MIGRATE_ZERO_PAGE_DETECTION ZERO_PAGE_DETECTION_MULTIFD
 #define DEFAULT_MIGRATE_MULTIFD_COMPRESSION MULTIFD_COMPRESSION_NONE
 /* 0: means nocompress, 1: best speed, ... 9: best compress ratio */
 #define DEFAULT_MIGRATE_MULTIFD_ZLIB_LEVEL 1
@@ -179,6 +184,14 @@ Property migration_properties[] = {
     DEFINE_PROP_MIG_MODE("mode", MigrationState,
                       parameters.mode,
                       MIG_MODE_NORMAL),
+    DEFINE_PROP_UINT8("bitmap-sync-threads", MigrationState,
+                      parameters.bitmap_sync_threads,
+                      DEFAULT_MIGRATE_BITMAP_SYNC_THREADS),
+    DEFINE_PROP_ZERO_PAGE_DETECTION("zero-page-detection", MigrationState,
+                      parameters.zero_page_detection,
+                      DEFAULT_MIGRATE_ZERO_PAGE_DETECTION),
+    DEFINE_PROP_UINT8("postcopy-place-threads", MigrationState,
+                      parameters.postcopy_place_threads, 0),
 
     /* Migration capabilities */
     DEFINE_PROP_MIG_CAP("x-xbzrle", MIGRATION_CAPABILITY_XBZRLE),
@@ -204,6 +217,9 @@ Property migration_properties[] = {
     DEFINE_PROP_MIG_CAP("x-switchover-ack",
                         MIGRATION_CAPABILITY_SWITCHOVER_ACK),
     DEFINE_PROP_MIG_CAP("x-dirty-limit", MIGRATION_CAPABILITY_DIRTY_LIMIT),
+    DEFINE_PROP_MIG_CAP("x-mapped-ram", MIGRATION_CAPABILITY_MAPPED_RAM),
+    DEFINE_PROP_MIG_CAP("x-defer-hot-pages",
+                        MIGRATION_CAPABILITY_DEFER_HOT_PAGES),
     DEFINE_PROP_END_OF_LIST(),
 };
 
@@ -242,6 +258,13 @@ bool migrate_compress(void)
     return s->capabilities[MIGRATION_CAPABILITY_COMPRESS];
 }
 
+bool migrate_defer_hot_pages(void)
+{
+    MigrationState *s = migrate_get_current();
+
+    return s->capabilities[MIGRATION_CAPABILITY_DEFER_HOT_PAGES];
+}
+
 bool migrate_dirty_bitmaps(void)
 {
     MigrationState *s = migrate_get_current();
@@ -277,6 +300,13 @@ bool migrate_late_block_activate(void)
     return s->capabilities[MIGRATION_CAPABILITY_LATE_BLOCK_ACTIVATE];
 }
 
+bool migrate_mapped_ram(void)
+{
+    MigrationState *s = migrate_get_current();
+
+    return s->capabilities[MIGRATION_CAPABILITY_MAPPED_RAM];
+}
+
 bool migrate_multifd(void)
 {
     MigrationState *s = migrate_get_current();
@@ -454,6 +484,17 @@ INITIALIZE_MIGRATE_CAPS_SET(check_caps_background_snapshot,
     MIGRATION_CAPABILITY_VALIDATE_UUID,
     MIGRATION_CAPABILITY_ZERO_COPY_SEND);
 
+/* Mapped-ram compatibility check list */
+static const
+INITIALIZE_MIGRATE_CAPS_SET(check_caps_mapped_ram,
+    MIGRATION_CAPABILITY_XBZRLE,
+    MIGRATION_CAPABILITY_COMPRESS,
+    MIGRATION_CAPABILITY_POSTCOPY_RAM,
+    MIGRATION_CAPABILITY_X_COLO,
+    MIGRATION_CAPABILITY_BACKGROUND_SNAPSHOT,
+    MIGRATION_CAPABILITY_ZERO_COPY_SEND,
+    MIGRATION_CAPABILITY_POSTCOPY_PREEMPT);
+
 static bool migrate_incoming_started(void)
 {
     return !!migration_incoming_get_current()->transport_data;
@@ -645,6 +686,34 @@ bool migrate_caps_check(bool *old_caps, bool *new_caps, Error **errp)
         }
     }
 
+    if (new_caps[MIGRATION_CAPABILITY_MAPPED_RAM]) {
+        int idx;
+
+        for (idx = 0; idx < check_caps_mapped_ram.size; idx++) {
+            int incomp_cap = check_caps_mapped_ram.caps[idx];
+            if (new_caps[incomp_cap]) {
+                error_setg(errp,
+                           "Mapped-ram migration is incompatible with %s",
+                           MigrationCapability_str(incomp_cap));
+                return false;
+            }
+        }
+
+        /* Pages must have a fixed size to have a fixed offset */
+        if (new_caps[MIGRATION_CAPABILITY_MULTIFD] &&
+            migrate_multifd_compression()) {
+            error_setg(errp, "Mapped-ram migration is incompatible with"
+                       " multifd compression");
+            return false;
+        }
+
+        if (migrate_incoming_started()) {
+            error_setg(errp,
+                       "Mapped-ram must be set before incoming starts");
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -837,6 +906,27 @@ MigMode migrate_mode(void)
     return s->parameters.mode;
 }
 
+int migrate_bitmap_sync_threads(void)
+{
+    MigrationState *s = migrate_get_current();
+
+    return s->parameters.bitmap_sync_threads;
+}
+
+ZeroPageDetection migrate_zero_page_detection(void)
+{
+    MigrationState *s = migrate_get_current();
+
+    return s->parameters.zero_page_detection;
+}
+
+int migrate_postcopy_place_threads(void)
+{
+    MigrationState *s = migrate_get_current();
+
+    return s->parameters.postcopy_place_threads;
+}
+
 int migrate_multifd_channels(void)
 {
     MigrationState *s = migrate_get_current();
@@ -1011,6 +1101,12 @@ MigrationParameters *qmp_query_migrate_parameters(Error **errp)
     params->vcpu_dirty_limit = s->parameters.vcpu_dirty_limit;
     params->has_mode = true;
     params->mode = s->parameters.mode;
+    params->has_bitmap_sync_threads = true;
+    params->bitmap_sync_threads = s->parameters.bitmap_sync_threads;
+    params->has_zero_page_detection = true;
+    params->zero_page_detection = s->parameters.zero_page_detection;
+    params->has_postcopy_place_threads = true;
+    params->postcopy_place_threads = s->parameters.postcopy_place_threads;
 
     return params;
 }
@@ -1047,6 +1143,9 @@ void migrate_params_init(MigrationParameters *params)
     params->has_x_vcpu_dirty_limit_period = true;
     params->has_vcpu_dirty_limit = true;
     params->has_mode = true;
+    params->has_bitmap_sync_threads = true;
+    params->has_zero_page_detection = true;
+    params->has_postcopy_place_threads = true;
 }
 
 /*
@@ -1138,6 +1237,25 @@ bool migrate_params_check(MigrationParameters *params, Error **errp)
         return false;
     }
 
+    if (params->has_bitmap_sync_threads &&
+        (params->bitmap_sync_threads < 1 ||
+         params->bitmap_sync_threads > MAX_BITMAP_SYNC_THREADS)) {
+        error_setg(errp, QERR_INVALID_PARAMETER_VALUE,
+                   "bitmap_sync_threads",
+                   "a value between 1 and "
+                   stringify(MAX_BITMAP_SYNC_THREADS));
+        return false;
+    }
+
+    if (params->has_postcopy_place_threads &&
+        params->postcopy_place_threads > MAX_POSTCOPY_PLACE_THREADS) {
+        error_setg(errp, QERR_INVALID_PARAMETER_VALUE,
+                   "postcopy_place_threads",
+                   "a value between 0 and "
+                   stringify(MAX_POSTCOPY_PLACE_THREADS));
+        return false;
+    }
+
     if (params->has_multifd_zlib_level &&
         (params->multifd_zlib_level > 9)) {
         error_setg(errp, QERR_INVALID_PARAMETER_VALUE, "multifd_zlib_level",
@@ -1216,6 +1334,13 @@ bool migrate_params_check(MigrationParameters *params, Error **errp)
     }
 #endif
 
+    if (migrate_mapped_ram() &&
+        params->has_multifd_compression && params->multifd_compression) {
+        error_setg(errp, "Mapped-ram migration is incompatible with"
+                   " multifd compression");
+        return false;
+    }
+
     if (params->has_x_vcpu_dirty_limit_period &&
         (params->x_vcpu_dirty_limit_period < 1 ||
          params->x_vcpu_dirty_limit_period > 1000)) {
@@ -1348,6 +1473,18 @@ static void migrate_params_test_apply(MigrateSetParameters *params,
     if (params->has_mode) {
         dest->mode = params->mode;
     }
+
+    if (params->has_bitmap_sync_threads) {
+        dest->bitmap_sync_threads = params->bitmap_sync_threads;
+    }
+
+    if (params->has_zero_page_detection) {
+        dest->zero_page_detection = params->zero_page_detection;
+    }
+
+    if (params->has_postcopy_place_threads) {
+        dest->postcopy_place_threads = params->postcopy_place_threads;
+    }
 }
 
 static void migrate_params_apply(MigrateSetParameters *params, Error **errp)
@@ -1492,6 +1629,18 @@ static void migrate_params_apply(MigrateSetParameters *params, Error **errp)
     if (params->has_mode) {
         s->parameters.mode = params->mode;
     }
+
+    if (params->has_bitmap_sync_threads) {
+        s->parameters.bitmap_sync_threads = params->bitmap_sync_threads;
+    }
+
+    if (params->has_zero_page_detection) {
+        s->parameters.zero_page_detection = params->zero_page_detection;
+    }
+
+    if (params->has_postcopy_place_threads) {
+        s->parameters.postcopy_place_threads = params->postcopy_place_threads;
+    }
 }
 
 void qmp_migrate_set_parameters(MigrateSetParameters *params, Error **errp)
@@ -567,6 +567,230 @@ int postcopy_ram_incoming_init(MigrationIncomingState *mis)
     return 0;
 }
 
+/*
+ * Placing a host page with UFFDIO_COPY copies it, which takes a while
+ * for huge pages, and the thread reading the stream cannot read the
+ * next page meanwhile; that includes pages a vCPU is waiting for when
+ * there is no preempt channel.  With postcopy-place-threads, the pages
+ * of the precopy channel are queued to a pool of threads instead.  The
+ * first idle thread takes the oldest page.  Pages of the preempt
+ * channel are still placed right away, they are few and urgent.
+ *
+ * A queued page owns a buffer: when a host page is complete, the
+ * channel's temporary page is queued and replaced with a free buffer.
+ * There is one buffer more than threads, so that a thread that finishes
+ * finds a page ready.  Without a free buffer, the reader waits.
+ */
+typedef struct {
+    void *host;
+    /* Data of the page, NULL for a zero page */
+    void *buf;
+    RAMBlock *rb;
+} PostcopyPlaceJob;
+
+struct PostcopyPlacer {
+    int nthreads;
+    QemuThread *threads;
+    /* Number of buffers, and of entries in the ring of jobs */
+    unsigned nbufs;
+
+    /* The fields below are protected by @lock */
+    QemuMutex lock;
+    /* Signalled when a job is queued, or the threads should quit */
+    QemuCond job_cond;
+    /* Signalled when a job is done */
+    QemuCond done_cond;
+    /* Jobs waiting for a thread */
+    PostcopyPlaceJob *jobs;
+    unsigned head;
+    unsigned count;
+    /* Buffers that no job holds */
+    void **free_bufs;
+    unsigned nfree;
+    /* Jobs queued or being placed */
+    unsigned inflight;
+    /* First error since the last flush */
+    int error;
+    bool quit;
+};
+
+static void *postcopy_place_thread(void *opaque)
+{
+    MigrationIncomingState *mis = opaque;
+    PostcopyPlacer *pl = mis->postcopy_placer;
+
+    rcu_register_thread();
+    qemu_mutex_lock(&pl->lock);
+    while (true) {
+        PostcopyPlaceJob job;
+        int ret;
+
+        while (!pl->count && !pl->quit) {
+            qemu_cond_wait(&pl->job_cond, &pl->lock);
+        }
+        /* Finish the queued pages before quitting */
+        if (!pl->count) {
+            break;
+        }
+        job = pl->jobs[pl->head];
+        pl->head = (pl->head + 1) % pl->nbufs;
+        pl->count--;
+        qemu_mutex_unlock(&pl->lock);
+
+        WITH_RCU_READ_LOCK_GUARD() {
+            if (job.buf) {
+                ret = postcopy_place_page(mis, job.host, job.buf, job.rb);
+            } else {
+                ret = postcopy_place_page_zero(mis, job.host, job.rb);
+            }
+        }
+
+        qemu_mutex_lock(&pl->lock);
+        if (job.buf) {
+            pl->free_bufs[pl->nfree++] = job.buf;
+        }
+        if (ret && !pl->error) {
+            pl->error = ret;
+        }
+        pl->inflight--;
+        qemu_cond_broadcast(&pl->done_cond);
+    }
+    qemu_mutex_unlock(&pl->lock);
+    rcu_unregister_thread();
+
+    return NULL;
+}
+
+static int postcopy_place_threads_setup(MigrationIncomingState *mis)
+{
+    int nthreads = migrate_postcopy_place_threads();
+    PostcopyPlacer *pl;
+    int i;
+
+    if (!nthreads) {
+        return 0;
+    }
+
+    pl = g_new0(PostcopyPlacer, 1);
+    pl->nbufs = nthreads + 1;
+    pl->jobs = g_new0(PostcopyPlaceJob, pl->nbufs);
+    pl->free_bufs = g_new0(void *, pl->nbufs);
+    mis->postcopy_placer = pl;
+
+    for (i = 0; i < pl->nbufs; i++) {
+        void *buf = mmap(NULL, mis->largest_page_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (buf == MAP_FAILED) {
+            int err = errno;
+
+            error_report("%s: Failed to map placing buffer: %s",
+                         __func__, strerror(err));
+            /* Clean up will be done later */
+            return -err;
+        }
+        pl->free_bufs[pl->nfree++] = buf;
+    }
+
+    qemu_mutex_init(&pl->lock);
+    qemu_cond_init(&pl->job_cond);
+    qemu_cond_init(&pl->done_cond);
+    pl->threads = g_new0(QemuThread, nthreads);
+    for (i = 0; i < nthreads; i++) {
+        qemu_thread_create(&pl->threads[i], "postcopy/place",
+                           postcopy_place_thread, mis, QEMU_THREAD_JOINABLE);
+    }
+    pl->nthreads = nthreads;
+    trace_postcopy_place_threads_setup(nthreads);
+
+    return 0;
+}
+
+static void postcopy_place_threads_cleanup(MigrationIncomingState *mis)
+{
+    PostcopyPlacer *pl = mis->postcopy_placer;
+    int i;
+
+    if (!pl) {
+        return;
+    }
+
+    if (pl->nthreads) {
+        WITH_QEMU_LOCK_GUARD(&pl->lock) {
+            pl->quit = true;
+            qemu_cond_broadcast(&pl->job_cond);
+        }
+        for (i = 0; i < pl->nthreads; i++) {
+            qemu_thread_join(&pl->threads[i]);
+        }
+        qemu_cond_destroy(&pl->done_cond);
+        qemu_cond_destroy(&pl->job_cond);
+        qemu_mutex_destroy(&pl->lock);
+    }
+
+    /* With the threads gone, every buffer is back */
+    for (i = 0; i < pl->nfree; i++) {
+        munmap(pl->free_bufs[i], mis->largest_page_size);
+    }
+    g_free(pl->threads);
+    g_free(pl->free_bufs);
+    g_free(pl->jobs);
+    g_free(pl);
+    mis->postcopy_placer = NULL;
+}
+
+int postcopy_place_page_queue(MigrationIncomingState *mis,
+                              PostcopyTmpPage *tmp_page, void *from,
+                              RAMBlock *rb)
+{
+    PostcopyPlacer *pl = mis->postcopy_placer;
+    PostcopyPlaceJob *job;
+    bool zero = tmp_page->all_zero;
+
+    if (!zero && from != tmp_page->tmp_huge_page) {
+        /* Read in place from the stream, it will be gone once queued */
+        memcpy(tmp_page->tmp_huge_page, from, qemu_ram_pagesize(rb));
+    }
+
+    QEMU_LOCK_GUARD(&pl->lock);
+    while ((pl->count == pl->nbufs || (!zero && !pl->nfree)) && !pl->error) {
+        qemu_cond_wait(&pl->done_cond, &pl->lock);
+    }
+    if (pl->error) {
+        return pl->error;
+    }
+
+    job = &pl->jobs[(pl->head + pl->count) % pl->nbufs];
+    job->host = tmp_page->host_addr;
+    job->rb = rb;
+    job->buf = NULL;
+    if (!zero) {
+        job->buf = tmp_page->tmp_huge_page;
+        tmp_page->tmp_huge_page = pl->free_bufs[--pl->nfree];
+    }
+    pl->count++;
+    pl->inflight++;
+    trace_postcopy_place_page_queue(job->host, pl->inflight);
+    qemu_cond_signal(&pl->job_cond);
+
+    return 0;
+}
+
+int postcopy_place_page_flush(MigrationIncomingState *mis)
+{
+    PostcopyPlacer *pl = mis->postcopy_placer;
+    int ret;
+
+    QEMU_LOCK_GUARD(&pl->lock);
+    while (pl->inflight) {
+        qemu_cond_wait(&pl->done_cond, &pl->lock);
+    }
+    ret = pl->error;
+    pl->error = 0;
+
+    return ret;
+}
+
 static void postcopy_temp_pages_cleanup(MigrationIncomingState *mis)
 {
     int i;
@@ -596,6 +820,8 @@ int postcopy_ram_incoming_cleanup(MigrationIncomingState *mis)
 {
     trace_postcopy_ram_incoming_cleanup_entry();
 
+    postcopy_place_threads_cleanup(mis);
+
     if (mis->preempt_thread_status == PREEMPT_THREAD_CREATED) {
         /* Notify the fast load thread to quit */
         mis->preempt_thread_status = PREEMPT_THREAD_QUIT;
@@ -1256,6 +1482,11 @@ int postcopy_ram_incoming_setup(MigrationIncomingState *mis)
         return -1;
     }
 
+    if (postcopy_place_threads_setup(mis)) {
+        /* Error dumped in the sub-function */
+        return -1;
+    }
+
     if (migrate_postcopy_preempt()) {
         /*
          * This thread needs to be created after the temp pages because
@@ -1451,6 +1682,20 @@ int postcopy_place_page_zero(MigrationIncomingState *mis, void *host,
     return -1;
 }
 
+int postcopy_place_page_queue(MigrationIncomingState *mis,
+                              PostcopyTmpPage *tmp_page, void *from,
+                              RAMBlock *rb)
+{
+    assert(0);
+    return -1;
+}
+
+int postcopy_place_page_flush(MigrationIncomingState *mis)
+{
+    assert(0);
+    return -1;
+}
+
 int postcopy_wake_shared(struct PostCopyFD *pcfd,
                          uint64_t client_addr,
                          RAMBlock *rb)
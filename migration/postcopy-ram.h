@@ -79,6 +79,23 @@ int postcopy_place_page(MigrationIncomingState *mis, void *host, void *from,
 int postcopy_place_page_zero(MigrationIncomingState *mis, void *host,
                              RAMBlock *rb);
 
+/*
+ * Hand the host page gathered in tmp_page to the placing threads.  The
+ * data is at (from), either tmp_page's buffer or a buffer that is only
+ * valid until the next read from the stream.  tmp_page gets a fresh
+ * buffer in exchange.
+ * returns 0 on success, or the error of an earlier placement
+ */
+int postcopy_place_page_queue(MigrationIncomingState *mis,
+                              PostcopyTmpPage *tmp_page, void *from,
+                              RAMBlock *rb);
+
+/*
+ * Wait until all queued pages are placed
+ * returns 0 on success, or the error of a placement since the last flush
+ */
+int postcopy_place_page_flush(MigrationIncomingState *mis);
+
 /* The current postcopy state is read/set by postcopy_state_get/set
  * which update it atomically.
  * The state is updated as postcopy messages are received, and
@@ -447,6 +447,39 @@ void qemu_put_buffer(QEMUFile *f, const uint8_t *buf, size_t size)
     }
 }
 
+/*
+ * Write @buflen bytes from @buf at @pos in the underlying channel,
+ * bypassing the buffer.  The stream position is left untouched, so
+ * this can be interleaved freely with the sequential qemu_put_*()
+ * functions.  Requires a seekable channel.
+ */
+void qemu_put_buffer_at(QEMUFile *f, const uint8_t *buf, size_t buflen,
+                        off_t pos)
+{
+    Error *err = NULL;
+    size_t done = 0;
+
+    if (f->last_error) {
+        return;
+    }
+
+    while (done < buflen) {
+        ssize_t ret = qio_channel_pwrite(f->ioc, (char *)buf + done,
+                                         buflen - done, pos + done, &err);
+        if (ret <= 0) {
+            if (!err) {
+                error_setg(&err, "Unexpected zero-length write at %lld",
+                           (long long)(pos + done));
+            }
+            qemu_file_set_error_obj(f, -EIO, err);
+            return;
+        }
+        done += ret;
+    }
+
+    stat64_add(&mig_stats.qemu_file_transferred, buflen);
+}
+
 void qemu_put_byte(QEMUFile *f, int v)
 {
     if (f->last_error) {
@@ -542,6 +575,40 @@ size_t coroutine_mixed_fn qemu_get_buffer(QEMUFile *f, uint8_t *buf, size_t size
     return done;
 }
 
+/*
+ * Read @buflen bytes at @pos in the underlying channel into @buf,
+ * bypassing the buffer and without moving the stream position.
+ *
+ * Returns the number of bytes read; anything short of @buflen also
+ * sets the file error.
+ */
+size_t qemu_get_buffer_at(QEMUFile *f, uint8_t *buf, size_t buflen,
+                          off_t pos)
+{
+    Error *err = NULL;
+    size_t done = 0;
+
+    if (f->last_error) {
+        return 0;
+    }
+
+    while (done < buflen) {
+        ssize_t ret = qio_channel_pread(f->ioc, (char *)buf + done,
+                                        buflen - done, pos + done, &err);
+        if (ret <= 0) {
+            if (!err) {
+                error_setg(&err, "Unexpected end of file at %lld",
+                           (long long)(pos + done));
+            }
+            qemu_file_set_error_obj(f, -EIO, err);
+            break;
+        }
+        done += ret;
+    }
+
+    return done;
+}
+
 /*
  * Read 'size' bytes of data from the file.
  * 'size' can be larger than the internal buffer.
@@ -801,6 +868,51 @@ QIOChannel *qemu_file_get_ioc(QEMUFile *file)
     return file->ioc;
 }
 
+/*
+ * Move the stream position of @f, flushing pending output or dropping
+ * buffered input first.
+ */
+void qemu_set_offset(QEMUFile *f, off_t off, int whence)
+{
+    Error *err = NULL;
+    off_t ret;
+
+    if (qemu_file_is_writable(f)) {
+        qemu_fflush(f);
+    } else {
+        /* Drop all cached buffers if existed; will trigger a re-fill later */
+        f->buf_index = 0;
+        f->buf_size = 0;
+    }
+
+    ret = qio_channel_io_seek(f->ioc, off, whence, &err);
+    if (ret == (off_t)-1) {
+        qemu_file_set_error_obj(f, -EIO, err);
+    }
+}
+
+/*
+ * Return the current stream position of @f, as seen by the qemu_put_*()
+ * and qemu_get_*() functions, or -1 on error.
+ */
+off_t qemu_get_offset(QEMUFile *f)
+{
+    Error *err = NULL;
+    off_t ret;
+
+    qemu_fflush(f);
+
+    ret = qio_channel_io_seek(f->ioc, 0, SEEK_CUR, &err);
+    if (ret == (off_t)-1) {
+        qemu_file_set_error_obj(f, -EIO, err);
+        return -1;
+    }
+    if (!qemu_file_is_writable(f)) {
+        ret -= f->buf_size - f->buf_index;
+    }
+    return ret;
+}
+
 /*
  * Read size bytes from QEMUFile f and write them to fd.
  */
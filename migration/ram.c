@@ -94,6 +94,52 @@
 #define RAM_SAVE_FLAG_MULTIFD_FLUSH    0x200
 /* We can't use any flag that is bigger than 0x200 */
 
+/*
+ * mapped-ram migration supports O_DIRECT, so we need to make sure the
+ * userspace buffer, the IO operation size and the file offset are
+ * aligned according to the underlying device's block size. The first
+ * two are already aligned to page size, but we need to add padding to
+ * the file to align the offset.  We cannot read the block size
+ * dynamically because the migration file can be moved between
+ * different systems, so use 1M to cover most block sizes and to keep
+ * the file offset aligned at page size as well.
+ */
+#define MAPPED_RAM_FILE_OFFSET_ALIGNMENT 0x100000
+
+/*
+ * When doing mapped-ram migration, this is the amount we read from
+ * the pages region in the migration file at a time.
+ */
+#define MAPPED_RAM_LOAD_BUF_SIZE 0x100000
+
+#define MAPPED_RAM_HDR_VERSION 1
+
+/*
+ * Written after the id and length of each RAMBlock in the setup
+ * section.  The bitmap of pages present in the file follows the
+ * header and the pages follow the bitmap, each at its offset within
+ * the block.
+ */
+struct MappedRamHeader {
+    uint32_t version;
+    /*
+     * The target's page size, so we know how many pages are in the
+     * bitmap.
+     */
+    uint64_t page_size;
+    /*
+     * The offset in the migration file where the pages bitmap is
+     * stored.
+     */
+    uint64_t bitmap_offset;
+    /*
+     * The offset in the migration file where the actual pages (data)
+     * are stored.
+     */
+    uint64_t pages_offset;
+} QEMU_PACKED;
+typedef struct MappedRamHeader MappedRamHeader;
+
 XBZRLECacheStats xbzrle_counters;
 
 /* used by the search for pages to send */
@@ -331,6 +377,45 @@ struct RAMSrcPageRequest {
     QSIMPLEQ_ENTRY(RAMSrcPageRequest) next_req;
 };
 
+/*
+ * Helper threads for migration_bitmap_sync().  Each synchronization splits
+ * the RAM blocks in chunks, which the migration thread and the helpers
+ * claim one at a time until none is left.
+ */
+typedef struct RAMSyncChunk {
+    RAMBlock *block;
+    ram_addr_t start;
+    ram_addr_t length;
+} RAMSyncChunk;
+
+typedef struct RAMSyncThreads {
+    unsigned int nr_threads;
+    QemuThread *threads;
+    QemuSemaphore start;
+    QemuSemaphore done;
+    bool quit;
+    /* The current synchronization */
+    GArray *chunks;
+    unsigned int next_chunk;
+    Stat64 new_dirty_pages;
+} RAMSyncThreads;
+
+/* Chunk size for RAM block synchronization, in target pages */
+#define RAM_SYNC_CHUNK_PAGES    (1ULL << 18)
+
+/*
+ * With defer-hot-pages, RAM is split in chunks that get a heat, which
+ * goes up each time a chunk is dirtied again after being sent and down
+ * after every other bitmap sync.  Hot chunks are skipped until the last
+ * stage or postcopy.  The decay makes sure that a chunk is never skipped
+ * for more than a few iterations in a row.
+ */
+#define HOT_CHUNK_SHIFT         9
+#define HOT_CHUNK_PAGES         (1UL << HOT_CHUNK_SHIFT)
+#define HOT_CHUNK_HEAT_STEP     4
+#define HOT_CHUNK_HEAT_MAX      8
+#define HOT_CHUNK_HEAT_DEFER    2
+
 /* State of RAM for migration */
 struct RAMState {
     /*
@@ -394,6 +479,14 @@ struct RAMState {
      * RAM migration.
      */
     unsigned int postcopy_bmap_sync_requested;
+
+    /* Only used if bitmap-sync-threads is more than one */
+    RAMSyncThreads sync;
+
+    /* Are hot chunks skipped?  Only with defer-hot-pages */
+    bool defer_hot_chunks;
+    /* Have we found nothing but hot chunks since the last bitmap sync? */
+    bool only_hot_chunks_left;
 };
 typedef struct RAMState RAMState;
 
@@ -407,6 +500,13 @@ static bool postcopy_has_request(RAMState *rs)
     return !QSIMPLEQ_EMPTY_ATOMIC(&rs->src_page_requests);
 }
 
+/* Whether the hot chunks are currently left out of the search */
+static bool ram_hot_chunks_deferred(RAMState *rs)
+{
+    return rs->defer_hot_chunks && !rs->last_stage &&
+           !migration_in_postcopy();
+}
+
 void precopy_infrastructure_init(void)
 {
     notifier_with_return_list_init(&precopy_notifier_list);
@@ -713,6 +813,18 @@ static void pss_find_next_dirty(PageSearchStatus *pss)
     }
 
     pss->page = find_next_bit(bitmap, size, pss->page);
+
+    /* Leave the chunks that keep being dirtied for later */
+    if (!pss->host_page_sending && rb->chunk_heat &&
+        ram_hot_chunks_deferred(ram_state)) {
+        while (pss->page < size &&
+               rb->chunk_heat[pss->page >> HOT_CHUNK_SHIFT] >=
+               HOT_CHUNK_HEAT_DEFER) {
+            pss->page = find_next_bit(bitmap, size,
+                                      QEMU_ALIGN_UP(pss->page + 1,
+                                                    HOT_CHUNK_PAGES));
+        }
+    }
 }
 
 static void migration_clear_memory_region_dirty_bitmap(RAMBlock *rb,
@@ -814,11 +926,53 @@ static inline bool migration_bitmap_clear_dirty(RAMState *rs,
     ret = test_and_clear_bit(page, rb->bmap);
     if (ret) {
         rs->migration_dirty_pages--;
+        if (rb->chunk_sent) {
+            set_bit(page >> HOT_CHUNK_SHIFT, rb->chunk_sent);
+        }
     }
 
     return ret;
 }
 
+/*
+ * ramblock_update_chunk_heat: account for the pages dirtied again
+ *
+ * Called after the dirty bitmap of @rb has been synchronized.  Chunks
+ * that had pages sent and are dirty again get hotter, and the others
+ * cool down.
+ *
+ * Returns the number of chunks that are hot enough to be deferred.
+ *
+ * @rb: RAMBlock to update
+ */
+static uint64_t ramblock_update_chunk_heat(RAMBlock *rb)
+{
+    unsigned long pages = rb->used_length >> TARGET_PAGE_BITS;
+    unsigned long chunks = DIV_ROUND_UP(pages, HOT_CHUNK_PAGES);
+    uint64_t hot = 0;
+    unsigned long i;
+
+    for (i = 0; i < chunks; i++) {
+        unsigned long start = i << HOT_CHUNK_SHIFT;
+        unsigned long end = MIN(start + HOT_CHUNK_PAGES, pages);
+        uint8_t heat = rb->chunk_heat[i];
+
+        if (test_bit(i, rb->chunk_sent) &&
+            find_next_bit(rb->bmap, end, start) < end) {
+            heat = MIN(heat + HOT_CHUNK_HEAT_STEP, HOT_CHUNK_HEAT_MAX);
+        } else if (heat) {
+            heat--;
+        }
+        rb->chunk_heat[i] = heat;
+        if (heat >= HOT_CHUNK_HEAT_DEFER) {
+            hot++;
+        }
+    }
+    bitmap_zero(rb->chunk_sent, chunks);
+
+    return hot;
+}
+
 static void dirty_bitmap_clear_section(MemoryRegionSection *section,
                                        void *opaque)
 {
@@ -904,6 +1058,124 @@ static void ramblock_sync_dirty_bitmap(RAMState *rs, RAMBlock *rb)
     rs->num_dirty_pages_period += new_dirty_pages;
 }
 
+/* Called with RCU critical section */
+static uint64_t ram_sync_claim_chunks(RAMSyncThreads *sync)
+{
+    uint64_t new_dirty_pages = 0;
+    unsigned int i;
+
+    while ((i = qatomic_fetch_inc(&sync->next_chunk)) < sync->chunks->len) {
+        RAMSyncChunk *c = &g_array_index(sync->chunks, RAMSyncChunk, i);
+
+        new_dirty_pages += cpu_physical_memory_sync_dirty_bitmap(c->block,
+                                                                 c->start,
+                                                                 c->length);
+    }
+    return new_dirty_pages;
+}
+
+static void *ram_sync_thread(void *opaque)
+{
+    RAMSyncThreads *sync = opaque;
+
+    rcu_register_thread();
+
+    while (true) {
+        qemu_sem_wait(&sync->start);
+        if (qatomic_read(&sync->quit)) {
+            break;
+        }
+        WITH_RCU_READ_LOCK_GUARD() {
+            stat64_add(&sync->new_dirty_pages, ram_sync_claim_chunks(sync));
+        }
+        qemu_sem_post(&sync->done);
+    }
+
+    rcu_unregister_thread();
+    return NULL;
+}
+
+static void ram_sync_threads_init(RAMSyncThreads *sync)
+{
+    unsigned int i;
+
+    sync->nr_threads = migrate_bitmap_sync_threads() - 1;
+    if (!sync->nr_threads) {
+        return;
+    }
+
+    sync->threads = g_new0(QemuThread, sync->nr_threads);
+    sync->chunks = g_array_new(false, false, sizeof(RAMSyncChunk));
+    qemu_sem_init(&sync->start, 0);
+    qemu_sem_init(&sync->done, 0);
+    sync->quit = false;
+    for (i = 0; i < sync->nr_threads; i++) {
+        qemu_thread_create(&sync->threads[i], "mig/src/sync", ram_sync_thread,
+                           sync, QEMU_THREAD_JOINABLE);
+    }
+}
+
+static void ram_sync_threads_cleanup(RAMSyncThreads *sync)
+{
+    unsigned int i;
+
+    if (!sync->nr_threads) {
+        return;
+    }
+
+    qatomic_set(&sync->quit, true);
+    for (i = 0; i < sync->nr_threads; i++) {
+        qemu_sem_post(&sync->start);
+    }
+    for (i = 0; i < sync->nr_threads; i++) {
+        qemu_thread_join(&sync->threads[i]);
+    }
+    qemu_sem_destroy(&sync->start);
+    qemu_sem_destroy(&sync->done);
+    g_array_free(sync->chunks, true);
+    g_free(sync->threads);
+    sync->nr_threads = 0;
+}
+
+/*
+ * Called with RCU critical section and bitmap_mutex held.  Returns the
+ * number of pages that were dirtied since the last synchronization.
+ */
+static uint64_t ram_sync_dirty_bitmaps_parallel(RAMSyncThreads *sync)
+{
+    RAMBlock *block;
+    uint64_t new_dirty_pages;
+    unsigned int i;
+
+    g_array_set_size(sync->chunks, 0);
+    RAMBLOCK_FOREACH_NOT_IGNORED(block) {
+        ram_addr_t chunk = RAM_SYNC_CHUNK_PAGES << TARGET_PAGE_BITS;
+        ram_addr_t start;
+
+        for (start = 0; start < block->used_length; start += chunk) {
+            RAMSyncChunk c = {
+                .block = block,
+                .start = start,
+                .length = MIN(chunk, block->used_length - start),
+            };
+            g_array_append_val(sync->chunks, c);
+        }
+    }
+
+    qatomic_set(&sync->next_chunk, 0);
+    stat64_set(&sync->new_dirty_pages, 0);
+    for (i = 0; i < sync->nr_threads; i++) {
+        qemu_sem_post(&sync->start);
+    }
+
+    new_dirty_pages = ram_sync_claim_chunks(sync);
+
+    for (i = 0; i < sync->nr_threads; i++) {
+        qemu_sem_wait(&sync->done);
+    }
+    return new_dirty_pages + stat64_get(&sync->new_dirty_pages);
+}
+
 /**
  * ram_pagesize_summary: calculate all the pagesizes of a VM
  *
@@ -1034,9 +1306,10 @@ static void migration_trigger_throttle(RAMState *rs)
 static void migration_bitmap_sync(RAMState *rs, bool last_stage)
 {
     RAMBlock *block;
-    int64_t end_time;
+    int64_t start_time, sync_time, end_time;
 
     stat64_add(&mig_stats.dirty_sync_count, 1);
+    start_time = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
 
     if (!rs->time_last_bitmap_sync) {
         rs->time_last_bitmap_sync = qemu_clock_get_ms(QEMU_CLOCK_REALTIME);
@@ -1047,8 +1320,25 @@ static void migration_bitmap_sync(RAMState *rs, bool last_stage)
 
     qemu_mutex_lock(&rs->bitmap_mutex);
     WITH_RCU_READ_LOCK_GUARD() {
-        RAMBLOCK_FOREACH_NOT_IGNORED(block) {
-            ramblock_sync_dirty_bitmap(rs, block);
+        if (rs->sync.nr_threads) {
+            uint64_t new_dirty_pages =
+                ram_sync_dirty_bitmaps_parallel(&rs->sync);
+
+            rs->migration_dirty_pages += new_dirty_pages;
+            rs->num_dirty_pages_period += new_dirty_pages;
+        } else {
+            RAMBLOCK_FOREACH_NOT_IGNORED(block) {
+                ramblock_sync_dirty_bitmap(rs, block);
+            }
+        }
+        if (rs->defer_hot_chunks) {
+            uint64_t hot_chunks = 0;
+
+            RAMBLOCK_FOREACH_NOT_IGNORED(block) {
+                hot_chunks += ramblock_update_chunk_heat(block);
+            }
+            rs->only_hot_chunks_left = false;
+            trace_migration_bitmap_sync_hot_chunks(hot_chunks);
         }
         stat64_set(&mig_stats.dirty_bytes_last_sync, ram_bytes_remaining());
     }
@@ -1057,6 +1347,10 @@ static void migration_bitmap_sync(RAMState *rs, bool last_stage)
     memory_global_after_dirty_log_sync();
     trace_migration_bitmap_sync_end(rs->num_dirty_pages_period);
 
+    sync_time = qemu_clock_get_us(QEMU_CLOCK_REALTIME) - start_time;
+    stat64_set(&mig_stats.dirty_sync_time, sync_time);
+    stat64_add(&mig_stats.dirty_sync_time_total, sync_time);
+
     end_time = qemu_clock_get_ms(QEMU_CLOCK_REALTIME);
 
     /* more than 1 second = 1000 millisecons */
@@ -1123,10 +1417,30 @@ static int save_zero_page(RAMState *rs, PageSearchStatus *pss,
     QEMUFile *file = pss->pss_channel;
     int len = 0;
 
+    if (migrate_zero_page_detection() == ZERO_PAGE_DETECTION_NONE) {
+        return 0;
+    }
+
+    /* The multifd send threads take care of it */
+    if (migrate_zero_page_detection() == ZERO_PAGE_DETECTION_MULTIFD &&
+        migrate_multifd() && !migration_in_postcopy()) {
+        return 0;
+    }
+
     if (!buffer_is_zero(p, TARGET_PAGE_SIZE)) {
         return 0;
     }
 
+    if (migrate_mapped_ram()) {
+        /*
+         * Nothing to write: a page absent from the file bitmap is
+         * zero on load.  The bit may have been set by an earlier pass.
+         */
+        ramblock_set_file_bmap_atomic(pss->block, offset, false);
+        stat64_add(&mig_stats.zero_pages, 1);
+        return 1;
+    }
+
     len += save_page_header(pss, file, pss->block, offset | RAM_SAVE_FLAG_ZERO);
     qemu_put_byte(file, 0);
     len += 1;
@@ -1190,6 +1504,15 @@ static int save_normal_page(PageSearchStatus *pss, RAMBlock *block,
 {
     QEMUFile *file = pss->pss_channel;
 
+    if (migrate_mapped_ram()) {
+        qemu_put_buffer_at(file, buf, TARGET_PAGE_SIZE,
+                           block->pages_offset + offset);
+        ramblock_set_file_bmap_atomic(block, offset, true);
+        ram_transferred_add(TARGET_PAGE_SIZE);
+        stat64_add(&mig_stats.normal_pages, 1);
+        return 1;
+    }
+
     ram_transferred_add(save_page_header(pss, pss->pss_channel, block,
                                          offset | RAM_SAVE_FLAG_PAGE));
     if (async) {
@@ -1256,7 +1579,6 @@ static int ram_save_multifd_page(QEMUFile *file, RAMBlock *block,
     if (multifd_queue_page(file, block, offset) < 0) {
         return -1;
     }
-    stat64_add(&mig_stats.normal_pages, 1);
 
     return 1;
 }
@@ -2321,6 +2643,10 @@ static int ram_find_and_save_block(RAMState *rs)
     rs->last_seen_block = pss->block;
     rs->last_page = pss->page;
 
+    if (!pages && rs->migration_dirty_pages && ram_hot_chunks_deferred(rs)) {
+        rs->only_hot_chunks_left = true;
+    }
+
     return pages;
 }
 
@@ -2365,6 +2691,7 @@ static void ram_state_cleanup(RAMState **rsp)
 {
     if (*rsp) {
         migration_page_queue_free(*rsp);
+        ram_sync_threads_cleanup(&(*rsp)->sync);
         qemu_mutex_destroy(&(*rsp)->bitmap_mutex);
         qemu_mutex_destroy(&(*rsp)->src_page_req_mutex);
         g_free(*rsp);
@@ -2413,6 +2740,15 @@ static void ram_save_cleanup(void *opaque)
         block->clear_bmap = NULL;
         g_free(block->bmap);
         block->bmap = NULL;
+        g_free(block->chunk_heat);
+        block->chunk_heat = NULL;
+        g_free(block->chunk_sent);
+        block->chunk_sent = NULL;
+    }
+
+    RAMBLOCK_FOREACH_MIGRATABLE(block) {
+        g_free(block->file_bmap);
+        block->file_bmap = NULL;
     }
 
     xbzrle_cleanup();
@@ -2743,6 +3079,8 @@ static int ram_state_init(RAMState **rsp)
      */
     (*rsp)->migration_dirty_pages = (*rsp)->ram_bytes_total >> TARGET_PAGE_BITS;
     ram_state_reset(*rsp);
+    ram_sync_threads_init(&(*rsp)->sync);
+    (*rsp)->defer_hot_chunks = migrate_defer_hot_pages();
 
     return 0;
 }
@@ -2782,6 +3120,12 @@ static void ram_list_init_bitmaps(void)
             bitmap_set(block->bmap, 0, pages);
             block->clear_bmap_shift = shift;
             block->clear_bmap = bitmap_new(clear_bmap_size(pages, shift));
+            if (migrate_defer_hot_pages()) {
+                unsigned long chunks = DIV_ROUND_UP(pages, HOT_CHUNK_PAGES);
+
+                block->chunk_heat = g_new0(uint8_t, chunks);
+                block->chunk_sent = bitmap_new(chunks);
+            }
         }
     }
 }
@@ -2924,6 +3268,100 @@ void qemu_guest_free_page_hint(void *addr, size_t len)
  * granularity of these critical sections.
  */
 
+void ramblock_set_file_bmap_atomic(RAMBlock *block, ram_addr_t offset,
+                                   bool set)
+{
+    if (set) {
+        set_bit_atomic(offset >> TARGET_PAGE_BITS, block->file_bmap);
+    } else {
+        clear_bit_atomic(offset >> TARGET_PAGE_BITS, block->file_bmap);
+    }
+}
+
+/*
+ * Reserve the space for @block in the migration file: a header, the
+ * bitmap of pages present and a region holding every page at its
+ * offset in the block.  The stream carries on after that region, so
+ * the file size is bounded by the size of guest RAM.
+ */
+static void mapped_ram_setup_ramblock(QEMUFile *file, RAMBlock *block)
+{
+    g_autofree MappedRamHeader *header = NULL;
+    size_t header_size, bitmap_size;
+    long num_pages;
+
+    header = g_new0(MappedRamHeader, 1);
+    header_size = sizeof(MappedRamHeader);
+
+    num_pages = block->used_length >> TARGET_PAGE_BITS;
+    bitmap_size = BITS_TO_LONGS(num_pages) * sizeof(unsigned long);
+
+    /*
+     * Save the file offsets of where the bitmap and the pages should
+     * go as they are written at the end of migration and during the
+     * iterative phase, respectively.
+     */
+    block->bitmap_offset = qemu_get_offset(file) + header_size;
+    block->pages_offset = ROUND_UP(block->bitmap_offset +
+                                   bitmap_size,
+                                   MAPPED_RAM_FILE_OFFSET_ALIGNMENT);
+    block->file_bmap = bitmap_new(num_pages);
+
+    header->version = cpu_to_be32(MAPPED_RAM_HDR_VERSION);
+    header->page_size = cpu_to_be64(TARGET_PAGE_SIZE);
+    header->bitmap_offset = cpu_to_be64(block->bitmap_offset);
+    header->pages_offset = cpu_to_be64(block->pages_offset);
+
+    qemu_put_buffer(file, (uint8_t *) header, header_size);
+
+    /* prepare offset for next ramblock */
+    qemu_set_offset(file, block->pages_offset + block->used_length, SEEK_SET);
+}
+
+static bool mapped_ram_read_header(QEMUFile *file, MappedRamHeader *header,
+                                   Error **errp)
+{
+    size_t ret, header_size = sizeof(MappedRamHeader);
+
+    ret = qemu_get_buffer(file, (uint8_t *)header, header_size);
+    if (ret != header_size) {
+        error_setg(errp, "Could not read whole mapped-ram migration header "
+                   "(expected %zd, got %zd bytes)", header_size, ret);
+        return false;
+    }
+
+    /* migration stream is big-endian */
+    header->version = be32_to_cpu(header->version);
+
+    if (header->version > MAPPED_RAM_HDR_VERSION) {
+        error_setg(errp, "Migration mapped-ram capability version not "
+                   "supported (expected <= %d, got %d)", MAPPED_RAM_HDR_VERSION,
+                   header->version);
+        return false;
+    }
+
+    header->page_size = be64_to_cpu(header->page_size);
+    header->bitmap_offset = be64_to_cpu(header->bitmap_offset);
+    header->pages_offset = be64_to_cpu(header->pages_offset);
+
+    return true;
+}
+
+/* Write the bitmaps of pages present once all pages are in the file */
+static void mapped_ram_save_bitmaps(QEMUFile *file)
+{
+    RAMBlock *block;
+
+    RAMBLOCK_FOREACH_MIGRATABLE(block) {
+        long num_pages = block->used_length >> TARGET_PAGE_BITS;
+        size_t bitmap_size = BITS_TO_LONGS(num_pages) * sizeof(unsigned long);
+
+        qemu_put_buffer_at(file, (uint8_t *)block->file_bmap, bitmap_size,
+                           block->bitmap_offset);
+        ram_transferred_add(bitmap_size);
+    }
+}
+
 /**
  * ram_save_setup: Setup RAM for migration
  *
@@ -2966,6 +3404,9 @@ static int ram_save_setup(QEMUFile *f, void *opaque)
             if (migrate_ignore_shared()) {
                 qemu_put_be64(f, block->mr->addr);
             }
+            if (migrate_mapped_ram()) {
+                mapped_ram_setup_ramblock(f, block);
+            }
         }
     }
 
@@ -3143,6 +3584,8 @@ static int ram_save_complete(QEMUFile *f, void *opaque)
     int ret = 0;
 
     rs->last_stage = !migration_in_colo_state();
+    /* Everything left has to be sent now, COLO included */
+    rs->defer_hot_chunks = false;
 
     WITH_RCU_READ_LOCK_GUARD() {
         if (!migration_in_postcopy()) {
@@ -3188,6 +3631,12 @@ static int ram_save_complete(QEMUFile *f, void *opaque)
         return ret;
     }
 
+    if (migrate_mapped_ram()) {
+        WITH_RCU_READ_LOCK_GUARD() {
+            mapped_ram_save_bitmaps(f);
+        }
+    }
+
     if (migrate_multifd() && !migrate_multifd_flush_after_each_section()) {
         qemu_put_be64(f, RAM_SAVE_FLAG_MULTIFD_FLUSH);
     }
@@ -3203,6 +3652,14 @@ static void ram_state_pending_estimate(void *opaque, uint64_t *must_precopy,
 
     uint64_t remaining_size = rs->migration_dirty_pages * TARGET_PAGE_SIZE;
 
+    /*
+     * When only deferred hot chunks are left, ask for an exact count: the
+     * bitmap sync it does is what lets them cool down or be sent.
+     */
+    if (rs->only_hot_chunks_left && ram_hot_chunks_deferred(rs)) {
+        remaining_size = 0;
+    }
+
     if (migrate_postcopy_ram()) {
         /* We can do postcopy, and all the data is postcopiable */
         *can_postcopy += remaining_size;
@@ -3220,7 +3677,8 @@ static void ram_state_pending_exact(void *opaque, uint64_t *must_precopy,
 
     uint64_t remaining_size = rs->migration_dirty_pages * TARGET_PAGE_SIZE;
 
-    if (!migration_in_postcopy() && remaining_size < s->threshold_size) {
+    if (!migration_in_postcopy() &&
+        (remaining_size < s->threshold_size || rs->only_hot_chunks_left)) {
         qemu_mutex_lock_iothread();
         WITH_RCU_READ_LOCK_GUARD() {
             migration_bitmap_sync_precopy(rs, false);
@@ -3718,7 +4176,10 @@ int ram_load_postcopy(QEMUFile *f, int channel)
         }
 
         if (!ret && place_needed) {
-            if (tmp_page->all_zero) {
+            if (channel == RAM_CHANNEL_PRECOPY && mis->postcopy_placer) {
+                ret = postcopy_place_page_queue(mis, tmp_page, place_source,
+                                                block);
+            } else if (tmp_page->all_zero) {
                 ret = postcopy_place_page_zero(mis, tmp_page->host_addr, block);
             } else {
                 ret = postcopy_place_page(mis, tmp_page->host_addr,
@@ -3729,6 +4190,15 @@ int ram_load_postcopy(QEMUFile *f, int channel)
         }
     }
 
+    /* Report placement errors before the caller moves on */
+    if (channel == RAM_CHANNEL_PRECOPY && mis->postcopy_placer) {
+        int place_ret = postcopy_place_page_flush(mis);
+
+        if (!ret) {
+            ret = place_ret;
+        }
+    }
+
     return ret;
 }
 
@@ -3789,6 +4259,120 @@ void colo_flush_ram_cache(void)
     trace_colo_flush_ram_cache_end();
 }
 
+/*
+ * Load the pages of @block marked in @bitmap from their offsets in the
+ * migration file, spreading the reads over the multifd channels if any.
+ */
+static bool read_ramblock_mapped_ram(QEMUFile *f, RAMBlock *block,
+                                     long num_pages, unsigned long *bitmap,
+                                     Error **errp)
+{
+    ERRP_GUARD();
+    unsigned long set_bit_idx, clear_bit_idx;
+    ram_addr_t offset;
+    void *host;
+    size_t read, unread, size;
+
+    for (set_bit_idx = find_first_bit(bitmap, num_pages);
+         set_bit_idx < num_pages;
+         set_bit_idx = find_next_bit(bitmap, num_pages, clear_bit_idx + 1)) {
+
+        clear_bit_idx = find_next_zero_bit(bitmap, num_pages, set_bit_idx + 1);
+
+        unread = TARGET_PAGE_SIZE * (clear_bit_idx - set_bit_idx);
+        offset = set_bit_idx << TARGET_PAGE_BITS;
+
+        while (unread > 0) {
+            host = host_from_ram_block_offset(block, offset);
+            if (!host) {
+                error_setg(errp, "page outside of ramblock %s range",
+                           block->idstr);
+                return false;
+            }
+
+            size = MIN(unread, MAPPED_RAM_LOAD_BUF_SIZE);
+
+            if (migrate_multifd()) {
+                if (multifd_recv_queue_file_pages(block, offset, size) < 0) {
+                    error_setg(errp, "multifd channels failed while loading"
+                               " ramblock %s", block->idstr);
+                    return false;
+                }
+                read = size;
+            } else {
+                read = qemu_get_buffer_at(f, host, size,
+                                          block->pages_offset + offset);
+                if (read != size) {
+                    goto err;
+                }
+            }
+            offset += read;
+            unread -= read;
+        }
+    }
+
+    return true;
+
+err:
+    qemu_file_get_error_obj(f, errp);
+    error_prepend(errp, "(%s) failed to read page " RAM_ADDR_FMT
+                  " from file offset %" PRIx64 ": ", block->idstr, offset,
+                  block->pages_offset + offset);
+    return false;
+}
+
+static void parse_ramblock_mapped_ram(QEMUFile *f, RAMBlock *block,
+                                      ram_addr_t length, Error **errp)
+{
+    g_autofree unsigned long *bitmap = NULL;
+    MappedRamHeader header;
+    size_t bitmap_size;
+    long num_pages;
+
+    if (!mapped_ram_read_header(f, &header, errp)) {
+        return;
+    }
+
+    if (header.page_size != TARGET_PAGE_SIZE) {
+        error_setg(errp, "Mapped-ram migration page size mismatch for"
+                   " ramblock %s (expected %d, got %" PRIu64 ")",
+                   block->idstr, TARGET_PAGE_SIZE, header.page_size);
+        return;
+    }
+
+    block->pages_offset = header.pages_offset;
+
+    /*
+     * Check the alignment of the file region that contains pages. We
+     * don't enforce MAPPED_RAM_FILE_OFFSET_ALIGNMENT to allow that
+     * value to change in the future. Do only a sanity check with page
+     * size alignment.
+     */
+    if (!QEMU_IS_ALIGNED(block->pages_offset, TARGET_PAGE_SIZE)) {
+        error_setg(errp,
+                   "Error reading ramblock %s pages, region has bad alignment",
+                   block->idstr);
+        return;
+    }
+
+    num_pages = length / header.page_size;
+    bitmap_size = BITS_TO_LONGS(num_pages) * sizeof(unsigned long);
+
+    bitmap = g_malloc0(bitmap_size);
+    if (qemu_get_buffer_at(f, (uint8_t *)bitmap, bitmap_size,
+                           header.bitmap_offset) != bitmap_size) {
+        error_setg(errp, "Error reading dirty bitmap");
+        return;
+    }
+
+    if (!read_ramblock_mapped_ram(f, block, num_pages, bitmap, errp)) {
+        return;
+    }
+
+    /* Skip pages array */
+    qemu_set_offset(f, block->pages_offset + length, SEEK_SET);
+}
+
 static int parse_ramblock(QEMUFile *f, RAMBlock *block, ram_addr_t length)
 {
     int ret = 0;
@@ -3832,6 +4416,15 @@ static int parse_ramblock(QEMUFile *f, RAMBlock *block, ram_addr_t length)
             return -EINVAL;
         }
     }
+    if (migrate_mapped_ram()) {
+        Error *local_err = NULL;
+
+        parse_ramblock_mapped_ram(f, block, length, &local_err);
+        if (local_err) {
+            error_report_err(local_err);
+            return -EINVAL;
+        }
+    }
     ret = rdma_block_notification_handle(f, block->idstr);
     if (ret < 0) {
         qemu_file_set_error(f, ret);
@@ -3866,6 +4459,12 @@ static int parse_ramblocks(QEMUFile *f, ram_addr_t total_ram_bytes)
         total_ram_bytes -= length;
     }
 
+    /* Wait for the multifd channels to finish loading the pages */
+    if (!ret && migrate_mapped_ram() && multifd_recv_sync_main() < 0) {
+        error_report("Failed to load the mapped-ram pages");
+        ret = -EIO;
+    }
+
     return ret;
 }
 
@@ -3996,13 +4595,16 @@ static int ram_load_precopy(QEMUFile *f)
             }
             break;
         case RAM_SAVE_FLAG_MULTIFD_FLUSH:
-            multifd_recv_sync_main();
+            if (multifd_recv_sync_main() < 0) {
+                ret = -EIO;
+            }
             break;
         case RAM_SAVE_FLAG_EOS:
             /* normal exit */
             if (migrate_multifd() &&
-                migrate_multifd_flush_after_each_section()) {
-                multifd_recv_sync_main();
+                migrate_multifd_flush_after_each_section() &&
+                multifd_recv_sync_main() < 0) {
+                ret = -EIO;
             }
             break;
         case RAM_SAVE_FLAG_HOOK:
@@ -300,6 +300,7 @@ int qemu_plugin_load_list(QemuPluginList *head, Error **errp)
     info->system_emulation = true;
     info->system.smp_vcpus = ms->smp.cpus;
     info->system.max_vcpus = ms->smp.max_cpus;
+    plugin.scoreboard_alloc_size = ms->smp.max_cpus;
 #else
     info->system_emulation = false;
 #endif
@@ -183,9 +183,13 @@ DEF("accel", HAS_ARG, QEMU_OPTION_accel,
     "                kernel-irqchip=on|off|split controls accelerated irqchip support (default=on)\n"
     "                kvm-shadow-mem=size of KVM shadow MMU in bytes\n"
     "                one-insn-per-tb=on|off (one guest instruction per TCG translation block)\n"
+    "                pin-globals=on|off (keep TCG globals in host registers across labels)\n"
+    "                profile=file (write a sampled TCG guest code profile to file)\n"
+    "                profile-freq=n (TCG profile samples per second, default 1000)\n"
     "                split-wx=on|off (enable TCG split w^x mapping)\n"
     "                tb-size=n (TCG translation block cache size)\n"
     "                dirty-ring-size=n (KVM dirty ring GFN count, default 0)\n"
+    "                dirty-ring-reapers=n (threads collecting KVM dirty rings, default 1)\n"
     "                eager-split-size=n (KVM Eager Page Split chunk size, default 0, disabled. ARM only)\n"
     "                notify-vmexit=run|internal-error|disable,notify-window=n (enable notify VM exit and set notify window, x86 only)\n"
     "                thread=single|multi (enable multi-threaded TCG)\n", QEMU_ARCH_ALL)
@@ -218,6 +222,26 @@ SRST
         can be useful in some situations, such as when trying to analyse
         the logs produced by the ``-d`` option.
 
+    ``pin-globals=on|off``
+        Selects the register allocation mode of the TCG accelerator. When
+        enabled, the guest registers that are used most within a
+        translation block are kept in call-saved host registers for the
+        whole block, rather than being reloaded from memory after each
+        internal branch. The default is off.
+
+    ``profile=file``
+        Samples the guest program counter of the running vCPUs at
+        regular intervals and writes a histogram of the samples into
+        ``file`` when QEMU exits.  Each line holds the symbol the
+        address belongs to, if the guest image has debug information,
+        the address and the number of samples, in the folded stack
+        format read by flame graph tools.  Only the start of each
+        translation block is sampled.
+
+    ``profile-freq=n``
+        Sets the number of samples per second and vCPU taken by
+        ``profile``, up to 1000.  The default is 1000.
+
     ``split-wx=on|off``
         Controls the use of split w^x mapping for the TCG code generation
         buffer. Some operating systems require this to be enabled, and in
@@ -245,6 +269,14 @@ SRST
         is disabled (dirty-ring-size=0).  When enabled, KVM will instead
         record dirty pages in a bitmap.
 
+    ``dirty-ring-reapers=n``
+        When the KVM dirty ring is in use, collecting the dirty pages from
+        the rings of all vCPUs is split among ``n`` threads, each of which
+        handles every ``n``-th vCPU.  With many vCPUs and a high dirty rate,
+        a single thread may fall behind, so that vCPUs keep stopping on a
+        full ring; ``query-migrate`` reports how often that happens.  The
+        default is 1.
+
     ``eager-split-size=n``
         KVM implements dirty page logging at the PAGE_SIZE granularity and
         enabling dirty-logging on a huge-page requires breaking it into
@@ -97,6 +97,66 @@ static void dma_blk_unmap(DMAAIOCB *dbs)
     qemu_iovec_reset(&dbs->iov);
 }
 
+/*
+ * Map as much of the remaining scatter-gather list as possible into
+ * dbs->iov.  The whole list is translated at once; mapping stops early
+ * if the bounce buffer is needed but busy.
+ */
+static void dma_blk_map(DMAAIOCB *dbs)
+{
+    QEMUSGList *sg = dbs->sg;
+    unsigned nsg = sg->nsg - dbs->sg_cur_index;
+    g_autofree MemoryMapEntry *ranges = g_new(MemoryMapEntry, nsg);
+    g_autofree struct iovec *iov = g_new(struct iovec, nsg);
+    dma_addr_t len;
+    unsigned i, j, n;
+
+    for (i = 0; i < nsg; i++) {
+        ranges[i].addr = sg->sg[dbs->sg_cur_index + i].base;
+        ranges[i].len = sg->sg[dbs->sg_cur_index + i].len;
+    }
+    ranges[0].addr += dbs->sg_cur_byte;
+    ranges[0].len -= dbs->sg_cur_byte;
+
+    n = dma_memory_map_batch(sg->as, ranges, nsg, iov, NULL, nsg, &len,
+                             dbs->dir, MEMTXATTRS_UNSPECIFIED);
+
+    for (i = 0; i < n; i++) {
+        /*
+         * Make reads deterministic in icount mode. Windows sometimes issues
+         * disk read requests with overlapping SGs. It leads
+         * to non-determinism, because resulting buffer contents may be mixed
+         * from several sectors. This code splits all SGs into several
+         * groups. SGs in every group do not overlap.
+         */
+        if (icount_enabled() && dbs->dir == DMA_DIRECTION_FROM_DEVICE) {
+            for (j = 0; j < dbs->iov.niov; ++j) {
+                if (ranges_overlap((intptr_t)dbs->iov.iov[j].iov_base,
+                                   dbs->iov.iov[j].iov_len,
+                                   (intptr_t)iov[i].iov_base,
+                                   iov[i].iov_len)) {
+                    break;
+                }
+            }
+            if (j < dbs->iov.niov) {
+                break;
+            }
+        }
+        qemu_iovec_add(&dbs->iov, iov[i].iov_base, iov[i].iov_len);
+        dbs->sg_cur_byte += iov[i].iov_len;
+        if (dbs->sg_cur_byte == sg->sg[dbs->sg_cur_index].len) {
+            dbs->sg_cur_byte = 0;
+            ++dbs->sg_cur_index;
+        }
+    }
+
+    /* Release what did not make it into this group. */
+    for (; i < n; i++) {
+        dma_memory_unmap(sg->as, iov[i].iov_base, iov[i].iov_len,
+                         dbs->dir, 0);
+    }
+}
+
 static void dma_complete(DMAAIOCB *dbs, int ret)
 {
     trace_dma_complete(dbs, ret, dbs->common.cb);
@@ -114,8 +174,6 @@ static void dma_blk_cb(void *opaque, int ret)
 {
     DMAAIOCB *dbs = (DMAAIOCB *)opaque;
     AioContext *ctx = dbs->ctx;
-    dma_addr_t cur_addr, cur_len;
-    void *mem;
 
     trace_dma_blk_cb(dbs, ret);
 
@@ -129,40 +187,7 @@ static void dma_blk_cb(void *opaque, int ret)
     }
     dma_blk_unmap(dbs);
 
-    while (dbs->sg_cur_index < dbs->sg->nsg) {
-        cur_addr = dbs->sg->sg[dbs->sg_cur_index].base + dbs->sg_cur_byte;
-        cur_len = dbs->sg->sg[dbs->sg_cur_index].len - dbs->sg_cur_byte;
-        mem = dma_memory_map(dbs->sg->as, cur_addr, &cur_len, dbs->dir,
-                             MEMTXATTRS_UNSPECIFIED);
-        /*
-         * Make reads deterministic in icount mode. Windows sometimes issues
-         * disk read requests with overlapping SGs. It leads
-         * to non-determinism, because resulting buffer contents may be mixed
-         * from several sectors. This code splits all SGs into several
-         * groups. SGs in every group do not overlap.
-         */
-        if (mem && icount_enabled() && dbs->dir == DMA_DIRECTION_FROM_DEVICE) {
-            int i;
-            for (i = 0 ; i < dbs->iov.niov ; ++i) {
-                if (ranges_overlap((intptr_t)dbs->iov.iov[i].iov_base,
-                                   dbs->iov.iov[i].iov_len, (intptr_t)mem,
-                                   cur_len)) {
-                    dma_memory_unmap(dbs->sg->as, mem, cur_len,
-                                     dbs->dir, cur_len);
-                    mem = NULL;
-                    break;
-                }
-            }
-        }
-        if (!mem)
-            break;
-        qemu_iovec_add(&dbs->iov, mem, cur_len);
-        dbs->sg_cur_byte += cur_len;
-        if (dbs->sg_cur_byte == dbs->sg->sg[dbs->sg_cur_index].len) {
-            dbs->sg_cur_byte = 0;
-            ++dbs->sg_cur_index;
-        }
-    }
+    dma_blk_map(dbs);
 
     if (dbs->iov.size == 0) {
         trace_dma_map_wait(dbs);
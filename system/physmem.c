@@ -70,6 +70,7 @@
 #include "migration/vmstate.h"
 
 #include "qemu/range.h"
+#include "qemu/stats64.h"
 #ifndef _WIN32
 #include "qemu/mmap-alloc.h"
 #endif
@@ -128,7 +129,11 @@ typedef struct PhysPageMap {
 } PhysPageMap;
 
 struct AddressSpaceDispatch {
-    MemoryRegionSection *mru_section;
+    /* Tells apart dispatches allocated at the same address. */
+    uint64_t gen;
+    /* Lookups served by the per-thread section cache, and misses. */
+    Stat64 cache_hits;
+    Stat64 cache_misses;
     /* This is a multi-level map on the physical address space.
      * The bottom level has pointers to MemoryRegionSections.
      */
@@ -332,18 +337,80 @@ static MemoryRegionSection *phys_page_find(AddressSpaceDispatch *d, hwaddr addr)
     }
 }
 
+/*
+ * Each thread remembers the last section it found in the few dispatches
+ * it used most recently.  Unlike a most-recently-used pointer in the
+ * dispatch itself, this is not written by every thread that accesses the
+ * address space, and two devices hammering different regions from
+ * different threads do not evict each other's entry.
+ *
+ * An entry is only valid while its dispatch is, i.e. during the RCU
+ * critical section in which it was filled, or later if the dispatch is
+ * still current.  The generation number tells a new dispatch from an old
+ * one that was freed and happens to be allocated at the same address.
+ */
+#define DISPATCH_CACHE_SIZE     4
+#define DISPATCH_CACHE_FLUSH    1024
+
+typedef struct DispatchCacheEntry {
+    AddressSpaceDispatch *d;
+    uint64_t gen;
+    MemoryRegionSection *section;
+    unsigned int hits;
+    unsigned int misses;
+} DispatchCacheEntry;
+
+static __thread DispatchCacheEntry dispatch_cache[DISPATCH_CACHE_SIZE];
+static __thread unsigned int dispatch_cache_next;
+
+/* Protected by the BQL, like all changes to the memory topology. */
+static uint64_t dispatch_gen;
+
+static void dispatch_cache_flush(DispatchCacheEntry *e)
+{
+    stat64_add(&e->d->cache_hits, e->hits);
+    stat64_add(&e->d->cache_misses, e->misses);
+    e->hits = e->misses = 0;
+}
+
+/* Called from RCU critical section */
+static DispatchCacheEntry *dispatch_cache_get(AddressSpaceDispatch *d)
+{
+    DispatchCacheEntry *e;
+    int i;
+
+    for (i = 0; i < DISPATCH_CACHE_SIZE; i++) {
+        e = &dispatch_cache[i];
+        if (e->d == d && e->gen == d->gen) {
+            return e;
+        }
+    }
+
+    /* The counts of the old entry are lost, its dispatch may be gone. */
+    e = &dispatch_cache[dispatch_cache_next++ % DISPATCH_CACHE_SIZE];
+    *e = (DispatchCacheEntry) { .d = d, .gen = d->gen };
+    return e;
+}
+
 /* Called from RCU critical section */
 static MemoryRegionSection *address_space_lookup_region(AddressSpaceDispatch *d,
                                                         hwaddr addr,
                                                         bool resolve_subpage)
 {
-    MemoryRegionSection *section = qatomic_read(&d->mru_section);
+    DispatchCacheEntry *e = dispatch_cache_get(d);
+    MemoryRegionSection *section = e->section;
     subpage_t *subpage;
 
     if (!section || section == &d->map.sections[PHYS_SECTION_UNASSIGNED] ||
         !section_covers_addr(section, addr)) {
         section = phys_page_find(d, addr);
-        qatomic_set(&d->mru_section, section);
+        e->section = section;
+        e->misses++;
+    } else {
+        e->hits++;
+    }
+    if (unlikely(e->hits + e->misses >= DISPATCH_CACHE_FLUSH)) {
+        dispatch_cache_flush(e);
     }
     if (resolve_subpage && section->mr->subpage) {
         subpage = container_of(section->mr, subpage_t, iomem);
@@ -2460,6 +2527,8 @@ AddressSpaceDispatch *address_space_dispatch_new(FlatView *fv)
     AddressSpaceDispatch *d = g_new0(AddressSpaceDispatch, 1);
     uint16_t n;
 
+    d->gen = ++dispatch_gen;
+
     n = dummy_section(&d->map, fv, &io_mem_unassigned);
     assert(n == PHYS_SECTION_UNASSIGNED);
 
@@ -3213,6 +3282,122 @@ void address_space_unmap(AddressSpace *as, void *buffer, hwaddr len,
     cpu_notify_map_clients();
 }
 
+/*
+ * Like flatview_translate, but first look in @cache, which holds the last
+ * section that was found for direct access.  Guest buffers usually come
+ * from the same RAM region, so most lookups can skip the dispatch walk.
+ *
+ * Called from RCU critical section.
+ */
+static MemoryRegion *flatview_translate_cached(FlatView *fv,
+                                               MemoryRegionSection *cache,
+                                               hwaddr addr, hwaddr *xlat,
+                                               hwaddr *plen, bool is_write,
+                                               MemTxAttrs attrs)
+{
+    MemoryRegionSection section;
+    AddressSpace *target_as = NULL;
+    Int128 diff;
+
+    if (cache->mr && section_covers_addr(cache, addr)) {
+        addr -= cache->offset_within_address_space;
+        *xlat = addr + cache->offset_within_region;
+        diff = int128_sub(cache->size, int128_make64(addr));
+        *plen = int128_get64(int128_min(diff, int128_make64(*plen)));
+        return cache->mr;
+    }
+
+    section = flatview_do_translate(fv, addr, xlat, plen, NULL,
+                                    is_write, true, &target_as, attrs);
+    if (!memory_access_is_direct(section.mr, is_write)) {
+        return section.mr;
+    }
+    if (xen_enabled()) {
+        hwaddr page = ((addr & TARGET_PAGE_MASK) + TARGET_PAGE_SIZE) - addr;
+        *plen = MIN(page, *plen);
+    } else if (!target_as) {
+        /*
+         * Behind an IOMMU the section belongs to another address space,
+         * and the translation of @addr is only valid for one IOTLB entry.
+         */
+        *cache = section;
+    }
+    return section.mr;
+}
+
+unsigned address_space_map_batch(AddressSpace *as,
+                                 const MemoryMapEntry *sg, unsigned nsg,
+                                 struct iovec *iov, hwaddr *iov_addr,
+                                 unsigned max_iov, hwaddr *plen,
+                                 bool is_write, MemTxAttrs attrs)
+{
+    MemoryRegionSection cache = { .mr = NULL };
+    hwaddr done = 0;
+    unsigned i, n = 0;
+    FlatView *fv;
+
+    RCU_READ_LOCK_GUARD();
+    fv = address_space_to_flatview(as);
+
+    for (i = 0; i < nsg; i++) {
+        hwaddr addr = sg[i].addr;
+        hwaddr len = sg[i].len;
+
+        while (len) {
+            hwaddr l, xlat, base, next_xlat;
+            MemoryRegion *mr;
+            void *p;
+
+            if (n == max_iov) {
+                goto out;
+            }
+
+            l = len;
+            mr = flatview_translate_cached(fv, &cache, addr, &xlat, &l,
+                                           is_write, attrs);
+            if (!memory_access_is_direct(mr, is_write)) {
+                /* Goes through the bounce buffer, of which there is one. */
+                l = len;
+                p = address_space_map(as, addr, &l, is_write, attrs);
+                if (!p) {
+                    goto out;
+                }
+            } else {
+                /* Same as flatview_extend_translation. */
+                base = xlat;
+                while (l < len) {
+                    hwaddr more = len - l;
+
+                    if (flatview_translate_cached(fv, &cache, addr + l,
+                                                  &next_xlat, &more, is_write,
+                                                  attrs) != mr ||
+                        next_xlat != base + l) {
+                        break;
+                    }
+                    l += more;
+                }
+                memory_region_ref(mr);
+                fuzz_dma_read_cb(addr, l, mr);
+                p = qemu_ram_ptr_length(mr->ram_block, base, &l, true);
+            }
+
+            iov[n].iov_base = p;
+            iov[n].iov_len = l;
+            if (iov_addr) {
+                iov_addr[n] = addr;
+            }
+            n++;
+            addr += l;
+            len -= l;
+            done += l;
+        }
+    }
+
+out:
+    *plen = done;
+    return n;
+}
+
 void *cpu_physical_memory_map(hwaddr addr,
                               hwaddr *plen,
                               bool is_write)
@@ -3643,6 +3828,8 @@ void mtree_print_dispatch(AddressSpaceDispatch *d, MemoryRegion *root)
     int i;
 
     qemu_printf("  Dispatch\n");
+    qemu_printf("    Lookup cache: %" PRIu64 " hits, %" PRIu64 " misses\n",
+                stat64_get(&d->cache_hits), stat64_get(&d->cache_misses));
     qemu_printf("    Physical sections\n");
 
     for (i = 0; i < d->map.sections_nb; ++i) {
@@ -3651,14 +3838,13 @@ void mtree_print_dispatch(AddressSpaceDispatch *d, MemoryRegion *root)
                                 " [ROM]", " [watch]" };
 
         qemu_printf("      #%d @" HWADDR_FMT_plx ".." HWADDR_FMT_plx
-                    " %s%s%s%s%s",
+                    " %s%s%s%s",
             i,
             s->offset_within_address_space,
             s->offset_within_address_space + MR_SIZE(s->size),
             s->mr->name ? s->mr->name : "(noname)",
             i < ARRAY_SIZE(names) ? names[i] : "",
             s->mr == root ? " [ROOT]" : "",
-            s == d->mru_section ? " [MRU]" : "",
             s->mr->is_iommu ? " [iommu]" : "");
 
         if (s->mr->alias) {
@@ -7188,11 +7188,13 @@ static void disas_simd_zip_trn(DisasContext *s, uint32_t insn)
     int opcode = extract32(insn, 12, 2);
     bool part = extract32(insn, 14, 1);
     bool is_q = extract32(insn, 30, 1);
-    int esize = 8 << size;
-    int i;
-    int datasize = is_q ? 128 : 64;
-    int elements = datasize / esize;
-    TCGv_i64 tcg_res[2], tcg_ele;
+    static void (* const fns[4])(unsigned, uint32_t, uint32_t, uint32_t,
+                                 bool, uint32_t, uint32_t) = {
+        NULL,
+        tcg_gen_gvec_uzp,
+        tcg_gen_gvec_trn,
+        tcg_gen_gvec_zip,
+    };
 
     if (opcode == 0 || (size == 3 && !is_q)) {
         unallocated_encoding(s);
@@ -7203,60 +7205,9 @@ static void disas_simd_zip_trn(DisasContext *s, uint32_t insn)
         return;
     }
 
-    tcg_res[0] = tcg_temp_new_i64();
-    tcg_res[1] = is_q ? tcg_temp_new_i64() : NULL;
-    tcg_ele = tcg_temp_new_i64();
-
-    for (i = 0; i < elements; i++) {
-        int o, w;
-
-        switch (opcode) {
-        case 1: /* UZP1/2 */
-        {
-            int midpoint = elements / 2;
-            if (i < midpoint) {
-                read_vec_element(s, tcg_ele, rn, 2 * i + part, size);
-            } else {
-                read_vec_element(s, tcg_ele, rm,
-                                 2 * (i - midpoint) + part, size);
-            }
-            break;
-        }
-        case 2: /* TRN1/2 */
-            if (i & 1) {
-                read_vec_element(s, tcg_ele, rm, (i & ~1) + part, size);
-            } else {
-                read_vec_element(s, tcg_ele, rn, (i & ~1) + part, size);
-            }
-            break;
-        case 3: /* ZIP1/2 */
-        {
-            int base = part * elements / 2;
-            if (i & 1) {
-                read_vec_element(s, tcg_ele, rm, base + (i >> 1), size);
-            } else {
-                read_vec_element(s, tcg_ele, rn, base + (i >> 1), size);
-            }
-            break;
-        }
-        default:
-            g_assert_not_reached();
-        }
-
-        w = (i * esize) / 64;
-        o = (i * esize) % 64;
-        if (o == 0) {
-            tcg_gen_mov_i64(tcg_res[w], tcg_ele);
-        } else {
-            tcg_gen_shli_i64(tcg_ele, tcg_ele, o);
-            tcg_gen_or_i64(tcg_res[w], tcg_res[w], tcg_ele);
-        }
-    }
-
-    for (i = 0; i <= is_q; ++i) {
-        write_vec_element(s, tcg_res[i], rd, i, MO_64);
-    }
-    clear_vec_high(s, is_q, rd);
+    fns[opcode](size, vec_full_reg_offset(s, rd),
+                vec_full_reg_offset(s, rn), vec_full_reg_offset(s, rm),
+                part, is_q ? 16 : 8, vec_full_reg_size(s));
 }
 
 /*
@@ -10113,12 +10064,6 @@ static void handle_vec_simd_wshli(DisasContext *s, bool is_q, bool is_u,
     int size = 32 - clz32(immh) - 1;
     int immhb = immh << 3 | immb;
     int shift = immhb - (8 << size);
-    int dsize = 64;
-    int esize = 8 << size;
-    int elements = dsize/esize;
-    TCGv_i64 tcg_rn = tcg_temp_new_i64();
-    TCGv_i64 tcg_rd = tcg_temp_new_i64();
-    int i;
 
     if (size >= 3) {
         unallocated_encoding(s);
@@ -10129,17 +10074,18 @@ static void handle_vec_simd_wshli(DisasContext *s, bool is_q, bool is_u,
         return;
     }
 
-    /* For the LL variants the store is larger than the load,
-     * so if rd == rn we would overwrite parts of our input.
-     * So load everything right now and use shifts in the main loop.
-     */
-    read_vec_element(s, tcg_rn, rn, is_q ? 1 : 0, MO_64);
-
-    for (i = 0; i < elements; i++) {
-        tcg_gen_shri_i64(tcg_rd, tcg_rn, i * esize);
-        ext_and_shift_reg(tcg_rd, tcg_rd, size | (!is_u << 2), 0);
-        tcg_gen_shli_i64(tcg_rd, tcg_rd, shift);
-        write_vec_element(s, tcg_rd, rd, i, size + 1);
+    /* The Q bit selects the source half; the result is always 128 bits. */
+    if (is_u) {
+        tcg_gen_gvec_uxtl(size, vec_full_reg_offset(s, rd),
+                          vec_full_reg_offset(s, rn), is_q,
+                          16, vec_full_reg_size(s));
+    } else {
+        tcg_gen_gvec_sxtl(size, vec_full_reg_offset(s, rd),
+                          vec_full_reg_offset(s, rn), is_q,
+                          16, vec_full_reg_size(s));
+    }
+    if (shift) {
+        gen_gvec_fn2i(s, true, rd, rd, shift, tcg_gen_gvec_shli, size + 1);
     }
 }
 
@@ -11569,8 +11515,8 @@ static void disas_simd_three_reg_same_extra(DisasContext *s, uint32_t insn)
         return;
 
     case 0x2: /* SDOT / UDOT */
-        gen_gvec_op4_ool(s, is_q, rd, rn, rm, rd, 0,
-                         u ? gen_helper_gvec_udot_b : gen_helper_gvec_sdot_b);
+        gen_gvec_fn4(s, is_q, rd, rn, rm, rd,
+                     u ? tcg_gen_gvec_udot : tcg_gen_gvec_sdot, MO_8);
         return;
 
     case 0x3: /* USDOT */
@@ -11907,6 +11853,13 @@ static void disas_simd_two_reg_misc(DisasContext *s, uint32_t insn)
             return;
         }
 
+        if (opcode == 0x12 && !u) {
+            /* XTN, XTN2: the Q bit selects the destination half. */
+            tcg_gen_gvec_xtn(size, vec_full_reg_offset(s, rd),
+                             vec_full_reg_offset(s, rn), is_q,
+                             16, vec_full_reg_size(s));
+            return;
+        }
         handle_2misc_narrow(s, false, opcode, u, is_q, size, rn, rd);
         return;
     case 0x4: /* CLS, CLZ */
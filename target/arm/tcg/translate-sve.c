@@ -3487,12 +3487,24 @@ DO_ZZI(UMIN, umin)
 
 #undef DO_ZZI
 
-static gen_helper_gvec_4 * const dot_fns[2][2] = {
-    { gen_helper_gvec_sdot_b, gen_helper_gvec_sdot_h },
-    { gen_helper_gvec_udot_b, gen_helper_gvec_udot_h }
-};
-TRANS_FEAT(DOT_zzzz, aa64_sve, gen_gvec_ool_zzzz,
-           dot_fns[a->u][a->sz], a->rd, a->rn, a->rm, a->ra, 0)
+static bool trans_DOT_zzzz(DisasContext *s, arg_DOT_zzzz *a)
+{
+    static GVecGen4Fn * const fns[2] = {
+        tcg_gen_gvec_sdot, tcg_gen_gvec_udot
+    };
+
+    if (!dc_isar_feature(aa64_sve, s)) {
+        return false;
+    }
+    if (sve_access_check(s)) {
+        unsigned vsz = vec_full_reg_size(s);
+        fns[a->u](MO_8 + a->sz, vec_full_reg_offset(s, a->rd),
+                  vec_full_reg_offset(s, a->rn),
+                  vec_full_reg_offset(s, a->rm),
+                  vec_full_reg_offset(s, a->ra), vsz, vsz);
+    }
+    return true;
+}
 
 /*
  * SVE Multiply - Indexed
@@ -635,6 +635,18 @@ bool x86_cpu_tlb_fill(CPUState *cs, vaddr addr, int size,
     raise_exception_err_ra(env, err.exception_index, err.error_code, retaddr);
 }
 
+bool x86_cpu_tlb_fill_large_pages(CPUState *cs, int mmu_idx)
+{
+    CPUX86State *env = cpu_env(cs);
+
+    /*
+     * With nested paging, the page size is the larger of the two stages,
+     * so the other pages it covers may translate differently.  The
+     * nested mmu_idx itself only walks the nested page tables.
+     */
+    return mmu_idx == MMU_NESTED_IDX || !(env->hflags2 & HF2_NPT_MASK);
+}
+
 G_NORETURN void x86_cpu_do_unaligned_access(CPUState *cs, vaddr vaddr,
                                             MMUAccessType access_type,
                                             int mmu_idx, uintptr_t retaddr)
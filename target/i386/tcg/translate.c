@@ -365,6 +365,21 @@ static void gen_update_cc_op(DisasContext *s)
     }
 }
 
+/*
+ * Return CC_OP as an argument for the cc_compute helpers.  If it is known
+ * at translation time, pass it as a constant instead of writing it back
+ * to env: the value stays dirty, and is only stored if something later
+ * needs it, which often does not happen because the next instruction
+ * sets the flags again.
+ */
+static TCGv_i32 gen_cc_op_arg(DisasContext *s)
+{
+    if (s->cc_op == CC_OP_DYNAMIC) {
+        return cpu_cc_op;
+    }
+    return tcg_constant_i32(s->cc_op);
+}
+
 #ifdef TARGET_X86_64
 
 #define NB_OP_SIZES 4
@@ -887,8 +902,7 @@ static void gen_compute_eflags(DisasContext *s)
         }
     }
 
-    gen_update_cc_op(s);
-    gen_helper_cc_compute_all(cpu_cc_src, dst, src1, src2, cpu_cc_op);
+    gen_helper_cc_compute_all(cpu_cc_src, dst, src1, src2, gen_cc_op_arg(s));
     set_cc_op(s, CC_OP_EFLAGS);
 }
 
@@ -968,9 +982,8 @@ static CCPrepare gen_prepare_eflags_c(DisasContext *s, TCGv reg)
     default:
        /* The need to compute only C from CC_OP_DYNAMIC is important
           in efficiently implementing e.g. INC at the start of a TB.  */
-       gen_update_cc_op(s);
        gen_helper_cc_compute_c(reg, cpu_cc_dst, cpu_cc_src,
-                               cpu_cc_src2, cpu_cc_op);
+                               cpu_cc_src2, gen_cc_op_arg(s));
        return (CCPrepare) { .cond = TCG_COND_NE, .reg = reg,
                             .mask = -1, .no_setcond = true };
     }
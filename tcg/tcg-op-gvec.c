@@ -3981,3 +3981,225 @@ void tcg_gen_gvec_bitsel(unsigned vece, uint32_t dofs, uint32_t aofs,
 
     tcg_gen_gvec_4(dofs, aofs, bofs, cofs, oprsz, maxsz, &g);
 }
+
+void tcg_gen_gvec_zip(unsigned vece, uint32_t dofs, uint32_t aofs,
+                      uint32_t bofs, bool high,
+                      uint32_t oprsz, uint32_t maxsz)
+{
+    static gen_helper_gvec_3 * const fns[4] = {
+        gen_helper_gvec_zip8, gen_helper_gvec_zip16,
+        gen_helper_gvec_zip32, gen_helper_gvec_zip64,
+    };
+
+    tcg_debug_assert(vece <= MO_64);
+    tcg_gen_gvec_3_ool(dofs, aofs, bofs, oprsz, maxsz, high, fns[vece]);
+}
+
+void tcg_gen_gvec_uzp(unsigned vece, uint32_t dofs, uint32_t aofs,
+                      uint32_t bofs, bool odd,
+                      uint32_t oprsz, uint32_t maxsz)
+{
+    static gen_helper_gvec_3 * const fns[4] = {
+        gen_helper_gvec_uzp8, gen_helper_gvec_uzp16,
+        gen_helper_gvec_uzp32, gen_helper_gvec_uzp64,
+    };
+
+    tcg_debug_assert(vece <= MO_64);
+    tcg_gen_gvec_3_ool(dofs, aofs, bofs, oprsz, maxsz, odd, fns[vece]);
+}
+
+/*
+ * Transposition only moves elements within pairs, so it can be done
+ * with shifts on elements twice the size, VECE being that size here.
+ */
+static void tcg_gen_trn1_vec(unsigned vece, TCGv_vec d,
+                             TCGv_vec a, TCGv_vec b)
+{
+    int half = 4 << vece;
+    TCGv_vec t = tcg_temp_new_vec_matching(d);
+
+    tcg_gen_shli_vec(vece, t, b, half);
+    tcg_gen_and_vec(vece, d, a,
+                    tcg_constant_vec_matching(d, vece,
+                                              MAKE_64BIT_MASK(0, half)));
+    tcg_gen_or_vec(vece, d, d, t);
+}
+
+static void tcg_gen_trn2_vec(unsigned vece, TCGv_vec d,
+                             TCGv_vec a, TCGv_vec b)
+{
+    int half = 4 << vece;
+    TCGv_vec t = tcg_temp_new_vec_matching(d);
+
+    tcg_gen_shri_vec(vece, t, a, half);
+    tcg_gen_and_vec(vece, d, b,
+                    tcg_constant_vec_matching(d, vece,
+                                              MAKE_64BIT_MASK(half, half)));
+    tcg_gen_or_vec(vece, d, d, t);
+}
+
+void tcg_gen_gvec_trn(unsigned vece, uint32_t dofs, uint32_t aofs,
+                      uint32_t bofs, bool odd,
+                      uint32_t oprsz, uint32_t maxsz)
+{
+    static const TCGOpcode vecop_list[] = {
+        INDEX_op_shli_vec, INDEX_op_shri_vec, 0
+    };
+    static const GVecGen3 g[2][4] = {
+        { { .fniv = tcg_gen_trn1_vec,
+            .fno = gen_helper_gvec_trn8,
+            .opt_opc = vecop_list,
+            .vece = MO_16 },
+          { .fniv = tcg_gen_trn1_vec,
+            .fno = gen_helper_gvec_trn16,
+            .opt_opc = vecop_list,
+            .vece = MO_32 },
+          { .fniv = tcg_gen_trn1_vec,
+            .fno = gen_helper_gvec_trn32,
+            .opt_opc = vecop_list,
+            .vece = MO_64 },
+          { .fno = gen_helper_gvec_trn64 } },
+        { { .fniv = tcg_gen_trn2_vec,
+            .fno = gen_helper_gvec_trn8,
+            .opt_opc = vecop_list,
+            .data = 1,
+            .vece = MO_16 },
+          { .fniv = tcg_gen_trn2_vec,
+            .fno = gen_helper_gvec_trn16,
+            .opt_opc = vecop_list,
+            .data = 1,
+            .vece = MO_32 },
+          { .fniv = tcg_gen_trn2_vec,
+            .fno = gen_helper_gvec_trn32,
+            .opt_opc = vecop_list,
+            .data = 1,
+            .vece = MO_64 },
+          { .fno = gen_helper_gvec_trn64,
+            .data = 1 } },
+    };
+
+    tcg_debug_assert(vece <= MO_64);
+    tcg_gen_gvec_3(dofs, aofs, bofs, oprsz, maxsz, &g[odd][vece]);
+}
+
+void tcg_gen_gvec_sxtl(unsigned vece, uint32_t dofs, uint32_t aofs,
+                       bool high, uint32_t oprsz, uint32_t maxsz)
+{
+    static gen_helper_gvec_2 * const fns[3] = {
+        gen_helper_gvec_sxtl8, gen_helper_gvec_sxtl16, gen_helper_gvec_sxtl32,
+    };
+
+    tcg_debug_assert(vece <= MO_32);
+    tcg_gen_gvec_2_ool(dofs, aofs, oprsz, maxsz, high, fns[vece]);
+}
+
+void tcg_gen_gvec_uxtl(unsigned vece, uint32_t dofs, uint32_t aofs,
+                       bool high, uint32_t oprsz, uint32_t maxsz)
+{
+    static gen_helper_gvec_2 * const fns[3] = {
+        gen_helper_gvec_uxtl8, gen_helper_gvec_uxtl16, gen_helper_gvec_uxtl32,
+    };
+
+    tcg_debug_assert(vece <= MO_32);
+    tcg_gen_gvec_2_ool(dofs, aofs, oprsz, maxsz, high, fns[vece]);
+}
+
+void tcg_gen_gvec_xtn(unsigned vece, uint32_t dofs, uint32_t aofs,
+                      bool high, uint32_t oprsz, uint32_t maxsz)
+{
+    static gen_helper_gvec_2 * const fns[3] = {
+        gen_helper_gvec_xtn8, gen_helper_gvec_xtn16, gen_helper_gvec_xtn32,
+    };
+
+    tcg_debug_assert(vece <= MO_32);
+    tcg_gen_gvec_2_ool(dofs, aofs, oprsz, maxsz, high, fns[vece]);
+}
+
+/*
+ * Dot products, with VECE the size of the accumulators: each narrow
+ * element is moved to the top of its accumulator lane and shifted back
+ * down with sign or zero extension, which the host can do on all lanes
+ * at once.
+ */
+static void tcg_gen_dot_vec(unsigned vece, TCGv_vec d, TCGv_vec a,
+                            TCGv_vec b, TCGv_vec c, bool sign)
+{
+    int bits = 8 << vece;
+    int narrow = bits / 4;
+    TCGv_vec ta = tcg_temp_new_vec_matching(d);
+    TCGv_vec tb = tcg_temp_new_vec_matching(d);
+    int i;
+
+    tcg_gen_mov_vec(d, c);
+    for (i = 0; i < 4; i++) {
+        int shl = bits - narrow * (i + 1);
+
+        tcg_gen_shli_vec(vece, ta, a, shl);
+        tcg_gen_shli_vec(vece, tb, b, shl);
+        if (sign) {
+            tcg_gen_sari_vec(vece, ta, ta, bits - narrow);
+            tcg_gen_sari_vec(vece, tb, tb, bits - narrow);
+        } else {
+            tcg_gen_shri_vec(vece, ta, ta, bits - narrow);
+            tcg_gen_shri_vec(vece, tb, tb, bits - narrow);
+        }
+        tcg_gen_mul_vec(vece, ta, ta, tb);
+        tcg_gen_add_vec(vece, d, d, ta);
+    }
+}
+
+static void tcg_gen_sdot_vec(unsigned vece, TCGv_vec d, TCGv_vec a,
+                             TCGv_vec b, TCGv_vec c)
+{
+    tcg_gen_dot_vec(vece, d, a, b, c, true);
+}
+
+static void tcg_gen_udot_vec(unsigned vece, TCGv_vec d, TCGv_vec a,
+                             TCGv_vec b, TCGv_vec c)
+{
+    tcg_gen_dot_vec(vece, d, a, b, c, false);
+}
+
+void tcg_gen_gvec_sdot(unsigned vece, uint32_t dofs, uint32_t aofs,
+                       uint32_t bofs, uint32_t cofs,
+                       uint32_t oprsz, uint32_t maxsz)
+{
+    static const TCGOpcode vecop_list[] = {
+        INDEX_op_shli_vec, INDEX_op_sari_vec, INDEX_op_mul_vec, 0
+    };
+    static const GVecGen4 g[2] = {
+        { .fniv = tcg_gen_sdot_vec,
+          .fno = gen_helper_gvec_sdot8,
+          .opt_opc = vecop_list,
+          .vece = MO_32 },
+        { .fniv = tcg_gen_sdot_vec,
+          .fno = gen_helper_gvec_sdot16,
+          .opt_opc = vecop_list,
+          .vece = MO_64 },
+    };
+
+    tcg_debug_assert(vece <= MO_16);
+    tcg_gen_gvec_4(dofs, aofs, bofs, cofs, oprsz, maxsz, &g[vece]);
+}
+
+void tcg_gen_gvec_udot(unsigned vece, uint32_t dofs, uint32_t aofs,
+                       uint32_t bofs, uint32_t cofs,
+                       uint32_t oprsz, uint32_t maxsz)
+{
+    static const TCGOpcode vecop_list[] = {
+        INDEX_op_shli_vec, INDEX_op_shri_vec, INDEX_op_mul_vec, 0
+    };
+    static const GVecGen4 g[2] = {
+        { .fniv = tcg_gen_udot_vec,
+          .fno = gen_helper_gvec_udot8,
+          .opt_opc = vecop_list,
+          .vece = MO_32 },
+        { .fniv = tcg_gen_udot_vec,
+          .fno = gen_helper_gvec_udot16,
+          .opt_opc = vecop_list,
+          .vece = MO_64 },
+    };
+
+    tcg_debug_assert(vece <= MO_16);
+    tcg_gen_gvec_4(dofs, aofs, bofs, cofs, oprsz, maxsz, &g[vece]);
+}
@@ -243,6 +243,7 @@ unsigned int tcg_max_ctxs;
 TCGv_env tcg_env;
 const void *tcg_code_gen_epilogue;
 uintptr_t tcg_splitwx_diff;
+bool tcg_pin_globals;
 
 #ifndef CONFIG_TCG_INTERPRETER
 tcg_prologue_fn *tcg_qemu_tb_exec;
@@ -4087,6 +4088,158 @@ liveness_pass_2(TCGContext *s)
     return changes;
 }
 
+/*
+ * Release the home registers given to globals by the previous call to
+ * pin_globals_pass.  Done unconditionally at the start of code generation,
+ * so that a restart after buffer overflow does not leak reserved registers.
+ */
+static void unpin_globals(TCGContext *s)
+{
+    TCGRegSet set = s->pinned_regs;
+
+    while (set) {
+        TCGReg reg = ctz64(set);
+
+        set &= set - 1;
+        s->pinned_temp[reg]->pinned = 0;
+        s->pinned_temp[reg] = NULL;
+    }
+    s->reserved_regs &= ~s->pinned_regs;
+    s->pinned_regs = 0;
+}
+
+/*
+ * Global pinning: give the most used direct globals of the TB a home in
+ * a call-saved host register.  They are loaded once at TB entry and stay
+ * in that register across labels and calls that do not write globals,
+ * instead of being reloaded at the start of every basic block.
+ *
+ * Liveness still keeps the canonical memory location up to date, so that
+ * the rest of the allocator and the exit paths see no difference; only
+ * the DEAD_ARG bits of pinned globals are cleared, as their register is
+ * never released.
+ */
+static void __attribute__((noinline))
+pin_globals_pass(TCGContext *s)
+{
+    int nb_globals = s->nb_globals;
+    TCGRegSet avail;
+    int *uses, *ebbs, *last_ebb;
+    int i, n, ebb, max_pins, order;
+    TCGOp *op;
+
+    avail = tcg_target_available_regs[TCG_TYPE_I64]
+            & ~tcg_target_call_clobber_regs & ~s->reserved_regs;
+
+    /* Leave at least half of the call-saved registers to the allocator. */
+    max_pins = ctpop64(avail) / 2;
+    if (max_pins == 0) {
+        return;
+    }
+
+    uses = tcg_malloc(sizeof(int) * nb_globals * 3);
+    memset(uses, 0, sizeof(int) * nb_globals * 3);
+    ebbs = uses + nb_globals;
+    last_ebb = ebbs + nb_globals;
+
+    ebb = 1;
+    QTAILQ_FOREACH(op, &s->ops, link) {
+        if (op->opc == INDEX_op_set_label) {
+            ebb++;
+            continue;
+        }
+        if (op->opc == INDEX_op_call) {
+            n = TCGOP_CALLO(op) + TCGOP_CALLI(op);
+        } else {
+            n = tcg_op_defs[op->opc].nb_oargs + tcg_op_defs[op->opc].nb_iargs;
+        }
+        for (i = 0; i < n; i++) {
+            size_t idx = temp_idx(arg_temp(op->args[i]));
+
+            if (idx < nb_globals) {
+                uses[idx]++;
+                if (last_ebb[idx] != ebb) {
+                    last_ebb[idx] = ebb;
+                    ebbs[idx]++;
+                }
+            }
+        }
+    }
+
+    /*
+     * Home registers are taken from the end of the allocation order,
+     * where they are least likely to be wanted by the local allocator.
+     */
+    order = ARRAY_SIZE(tcg_target_reg_alloc_order);
+    for (n = 0; n < max_pins; n++) {
+        TCGTemp *best = NULL;
+        int best_uses = 2;
+        TCGReg reg;
+
+        for (i = 0; i < nb_globals; i++) {
+            TCGTemp *ts = &s->temps[i];
+
+            if (ts->kind != TEMP_GLOBAL || ts->pinned || ts->indirect_reg
+                || ts->mem_base->kind != TEMP_FIXED
+                || ts->type != ts->base_type
+                || (ts->type != TCG_TYPE_I32 && ts->type != TCG_TYPE_I64)
+                || ebbs[i] < 2 || uses[i] <= best_uses) {
+                continue;
+            }
+            best = ts;
+            best_uses = uses[i];
+        }
+        if (!best) {
+            break;
+        }
+
+        do {
+            reg = tcg_target_reg_alloc_order[--order];
+        } while (!tcg_regset_test_reg(avail, reg));
+
+        best->pinned = 1;
+        s->pinned_temp[reg] = best;
+        tcg_regset_set_reg(s->pinned_regs, reg);
+    }
+    s->reserved_regs |= s->pinned_regs;
+
+    if (!s->pinned_regs) {
+        return;
+    }
+
+    QTAILQ_FOREACH(op, &s->ops, link) {
+        int nb_oargs, nb_iargs;
+
+        if (op->opc == INDEX_op_call) {
+            nb_oargs = TCGOP_CALLO(op);
+            nb_iargs = TCGOP_CALLI(op);
+        } else {
+            nb_oargs = tcg_op_defs[op->opc].nb_oargs;
+            nb_iargs = tcg_op_defs[op->opc].nb_iargs;
+        }
+        for (i = 0; i < nb_oargs + nb_iargs; i++) {
+            TCGTemp *ts = arg_temp(op->args[i]);
+            int j;
+
+            if (!ts->pinned) {
+                continue;
+            }
+            /*
+             * An input that is overwritten by the op itself may still
+             * be reported dead: the output takes over its register.
+             */
+            for (j = 0; i >= nb_oargs && j < nb_oargs; j++) {
+                if (arg_temp(op->args[j]) == ts) {
+                    break;
+                }
+            }
+            if (i < nb_oargs || j == nb_oargs) {
+                op->life &= ~(DEAD_ARG << i);
+            }
+        }
+    }
+}
+
 static void temp_allocate_frame(TCGContext *s, TCGTemp *ts)
 {
     intptr_t off;
@@ -4187,12 +4340,33 @@ static void set_temp_val_nonreg(TCGContext *s, TCGTemp *ts, TCGTempVal type)
 
 static void temp_load(TCGContext *, TCGTemp *, TCGRegSet, TCGRegSet, TCGRegSet);
 
+/* Return the home register of the pinned global TS.  */
+static TCGReg temp_pinned_reg(TCGContext *s, TCGTemp *ts)
+{
+    TCGRegSet set = s->pinned_regs;
+
+    while (set) {
+        TCGReg reg = ctz64(set);
+
+        if (s->pinned_temp[reg] == ts) {
+            return reg;
+        }
+        set &= set - 1;
+    }
+    g_assert_not_reached();
+}
+
 /* Mark a temporary as free or dead.  If 'free_or_dead' is negative,
    mark it free; otherwise mark it dead.  */
 static void temp_free_or_dead(TCGContext *s, TCGTemp *ts, int free_or_dead)
 {
     TCGTempVal new_type;
 
+    /* A pinned global keeps its register until explicitly freed.  */
+    if (ts->pinned && free_or_dead > 0) {
+        return;
+    }
+
     switch (ts->kind) {
     case TEMP_FIXED:
         return;
@@ -4389,6 +4563,24 @@ static TCGReg tcg_reg_alloc_pair(TCGContext *s, TCGRegSet required_regs,
     g_assert_not_reached();
 }
 
+/* Choose the register into which temp_load brings TS.  A pinned global
+   goes to its home register, which is reserved and thus never handed
+   out by tcg_reg_alloc.  */
+static TCGReg temp_load_reg(TCGContext *s, TCGTemp *ts, TCGRegSet desired_regs,
+                            TCGRegSet allocated_regs, TCGRegSet preferred_regs)
+{
+    if (unlikely(ts->pinned)) {
+        TCGReg reg = temp_pinned_reg(s, ts);
+
+        if (tcg_regset_test_reg(desired_regs, reg)
+            && s->reg_to_temp[reg] == NULL) {
+            return reg;
+        }
+    }
+    return tcg_reg_alloc(s, desired_regs, allocated_regs,
+                         preferred_regs, ts->indirect_base);
+}
+
 /* Make sure the temporary is in a register.  If needed, allocate the register
    from DESIRED while avoiding ALLOCATED.  */
 static void temp_load(TCGContext *s, TCGTemp *ts, TCGRegSet desired_regs,
@@ -4400,8 +4592,8 @@ static void temp_load(TCGContext *s, TCGTemp *ts, TCGRegSet desired_regs,
     case TEMP_VAL_REG:
         return;
     case TEMP_VAL_CONST:
-        reg = tcg_reg_alloc(s, desired_regs, allocated_regs,
-                            preferred_regs, ts->indirect_base);
+        reg = temp_load_reg(s, ts, desired_regs, allocated_regs,
+                            preferred_regs);
         if (ts->type <= TCG_TYPE_I64) {
             tcg_out_movi(s, ts->type, reg, ts->val);
         } else {
@@ -4426,8 +4618,8 @@ static void temp_load(TCGContext *s, TCGTemp *ts, TCGRegSet desired_regs,
         ts->mem_coherent = 0;
         break;
     case TEMP_VAL_MEM:
-        reg = tcg_reg_alloc(s, desired_regs, allocated_regs,
-                            preferred_regs, ts->indirect_base);
+        reg = temp_load_reg(s, ts, desired_regs, allocated_regs,
+                            preferred_regs);
         tcg_out_ld(s, ts->type, reg, ts->mem_base->reg, ts->mem_offset);
         ts->mem_coherent = 1;
         break;
@@ -4438,13 +4630,51 @@ static void temp_load(TCGContext *s, TCGTemp *ts, TCGRegSet desired_regs,
     set_temp_val_reg(s, ts, reg);
 }
 
+/*
+ * Put every pinned global back into its home register, if the last op
+ * left it anywhere else.  Between ops, pinned globals are thus always in
+ * their home register, and since that register is reserved, every branch
+ * reaching a label agrees on where they are.
+ */
+static void tcg_reg_alloc_pinned(TCGContext *s)
+{
+    TCGRegSet set = s->pinned_regs;
+
+    while (set) {
+        TCGReg reg = ctz64(set);
+        TCGTemp *ts = s->pinned_temp[reg];
+
+        set &= set - 1;
+        switch (ts->val_type) {
+        case TEMP_VAL_REG:
+            if (ts->reg == reg) {
+                continue;
+            }
+            tcg_out_mov(s, ts->type, reg, ts->reg);
+            break;
+        case TEMP_VAL_CONST:
+            tcg_out_movi(s, ts->type, reg, ts->val);
+            break;
+        case TEMP_VAL_MEM:
+            tcg_out_ld(s, ts->type, reg, ts->mem_base->reg, ts->mem_offset);
+            ts->mem_coherent = 1;
+            break;
+        default:
+            g_assert_not_reached();
+        }
+        tcg_debug_assert(s->reg_to_temp[reg] == NULL);
+        set_temp_val_reg(s, ts, reg);
+    }
+}
+
 /* Save a temporary to memory. 'allocated_regs' is used in case a
    temporary registers needs to be allocated to store a constant.  */
 static void temp_save(TCGContext *s, TCGTemp *ts, TCGRegSet allocated_regs)
 {
     /* The liveness analysis already ensures that globals are back
        in memory. Keep an tcg_debug_assert for safety. */
-    tcg_debug_assert(ts->val_type == TEMP_VAL_MEM || temp_readonly(ts));
+    tcg_debug_assert(ts->val_type == TEMP_VAL_MEM || temp_readonly(ts)
+                     || (ts->pinned && ts->mem_coherent));
 }
 
 /* save globals to their canonical location and assume they can be
@@ -5029,6 +5259,10 @@ static void tcg_reg_alloc_op(TCGContext *s, const TCGOp *op)
                     reg = tcg_reg_alloc(s, arg_ct->regs,
                                         i_allocated_regs | o_allocated_regs,
                                         output_pref(op, k), ts->indirect_base);
+                } else if (ts->pinned
+                           && tcg_regset_test_reg(arg_ct->regs,
+                                                  temp_pinned_reg(s, ts))) {
+                    reg = temp_pinned_reg(s, ts);
                 } else {
                     reg = tcg_reg_alloc(s, arg_ct->regs, o_allocated_regs,
                                         output_pref(op, k), ts->indirect_base);
@@ -5349,6 +5583,12 @@ static void tcg_reg_alloc_call(TCGContext *s, TCGOp *op)
         sync_globals(s, allocated_regs);
     } else {
         save_globals(s, allocated_regs);
+        /* The helper may change pinned globals: reload them afterward. */
+        for (i = 0; i < TCG_TARGET_NB_REGS; i++) {
+            if (tcg_regset_test_reg(s->pinned_regs, i)) {
+                set_temp_val_nonreg(s, s->pinned_temp[i], TEMP_VAL_MEM);
+            }
+        }
     }
 
     /*
@@ -6052,9 +6292,12 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
     }
 #endif
 
+    unpin_globals(s);
+
     tcg_optimize(s);
 
     reachable_code_pass(s);
+
     liveness_pass_0(s);
     liveness_pass_1(s);
 
@@ -6088,6 +6331,10 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
         }
     }
 
+    if (qatomic_read(&tcg_pin_globals)) {
+        pin_globals_pass(s);
+    }
+
     /* Initialize goto_tb jump offsets. */
     tb->jmp_reset_offset[0] = TB_JMP_OFFSET_INVALID;
     tb->jmp_reset_offset[1] = TB_JMP_OFFSET_INVALID;
@@ -6116,6 +6363,7 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
         tcg_malloc(sizeof(uint64_t) * s->gen_tb->icount * start_words);
 
     tcg_out_tb_start(s);
+    tcg_reg_alloc_pinned(s);
 
     num_insns = -1;
     QTAILQ_FOREACH(op, &s->ops, link) {
@@ -6173,6 +6421,9 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
             tcg_reg_alloc_op(s, op);
             break;
         }
+        if (s->pinned_regs) {
+            tcg_reg_alloc_pinned(s);
+        }
         /* Test for (pending) buffer overflow.  The assumption is that any
            one operation beginning below the high water mark cannot overrun
            the buffer completely.  Thus we can test for overflow after
@@ -0,0 +1,147 @@
+/*
+ * fp-test-batch.c - test QEMU's batched softfloat operations
+ *
+ * The batched operations must produce the same results and flags as
+ * the scalar operations applied to each element in turn.
+ *
+ * License: GNU GPL, version 2 or later.
+ *   See the COPYING file in the top-level directory.
+ */
+#ifndef HW_POISON_H
+#error Must define HW_POISON_H to work around TARGET_* poisoning
+#endif
+
+#include "qemu/osdep.h"
+#include "fpu/softfloat.h"
+
+#define N 37    /* not a multiple of the chunk size */
+
+typedef float32 (*f32_op_fn)(float32, float32, float_status *);
+typedef void (*f32_op_n_fn)(float32 *, const float32 *, const float32 *,
+                            size_t, float_status *);
+typedef float64 (*f64_op_fn)(float64, float64, float_status *);
+typedef void (*f64_op_n_fn)(float64 *, const float64 *, const float64 *,
+                            size_t, float_status *);
+
+static const struct {
+    const char *name;
+    f32_op_fn f32;
+    f32_op_n_fn f32_n;
+    f64_op_fn f64;
+    f64_op_n_fn f64_n;
+} ops[] = {
+    { "add", float32_add, float32_add_n, float64_add, float64_add_n },
+    { "sub", float32_sub, float32_sub_n, float64_sub, float64_sub_n },
+    { "mul", float32_mul, float32_mul_n, float64_mul, float64_mul_n },
+    { "div", float32_div, float32_div_n, float64_div, float64_div_n },
+};
+
+static const FloatRoundMode modes[] = {
+    float_round_nearest_even,
+    float_round_to_zero,
+};
+
+static int errors;
+
+/* Mostly ordinary numbers, with the occasional special value.  */
+static uint64_t random_bits(int bits)
+{
+    uint64_t r = ((uint64_t)mrand48() << 32) ^ (uint32_t)mrand48();
+
+    switch (r & 15) {
+    case 0:
+        return 0;                       /* zero */
+    case 1:
+        return r >> (64 - (bits == 32 ? 23 : 52));  /* denormal */
+    case 2:
+        return -1ull >> (64 - bits);    /* NaN */
+    case 3:
+        /* large exponent, may overflow */
+        return (r | (0x3ull << (bits - 3))) & (-1ull >> (64 - bits));
+    default:
+        /* exponents around 1, occasionally tiny */
+        r &= -1ull >> (64 - bits);
+        r &= ~(0x3ull << (bits - 3));
+        return r & 8 ? r : r | (0x1ull << (bits - 3));
+    }
+}
+
+static void check(const char *name, int bits, int mode, int i,
+                  uint64_t exp, uint64_t got, int exp_flags, int got_flags)
+{
+    if (exp == got && exp_flags == got_flags) {
+        return;
+    }
+    printf("f%d_%s mode %d element %d: expected %016" PRIx64
+           " flags %#x, got %016" PRIx64 " flags %#x\n",
+           bits, name, mode, i, exp, exp_flags, got, got_flags);
+    if (++errors == 20) {
+        exit(1);
+    }
+}
+
+static void test_f32(int op, int mode, bool inexact)
+{
+    float_status qsf = { 0 }, vsf;
+    float32 a[N], b[N], r[N], v[N];
+    int i;
+
+    set_float_rounding_mode(modes[mode], &qsf);
+    set_float_exception_flags(inexact ? float_flag_inexact : 0, &qsf);
+    vsf = qsf;
+
+    for (i = 0; i < N; i++) {
+        a[i] = make_float32(random_bits(32));
+        b[i] = make_float32(random_bits(32));
+        r[i] = ops[op].f32(a[i], b[i], &qsf);
+    }
+    /* In place, as the helpers do with vd == vn.  */
+    memcpy(v, a, sizeof(v));
+    ops[op].f32_n(v, v, b, N, &vsf);
+
+    for (i = 0; i < N; i++) {
+        check(ops[op].name, 32, mode, i, float32_val(r[i]), float32_val(v[i]),
+              i == N - 1 ? get_float_exception_flags(&qsf) : 0,
+              i == N - 1 ? get_float_exception_flags(&vsf) : 0);
+    }
+}
+
+static void test_f64(int op, int mode, bool inexact)
+{
+    float_status qsf = { 0 }, vsf;
+    float64 a[N], b[N], r[N], v[N];
+    int i;
+
+    set_float_rounding_mode(modes[mode], &qsf);
+    set_float_exception_flags(inexact ? float_flag_inexact : 0, &qsf);
+    vsf = qsf;
+
+    for (i = 0; i < N; i++) {
+        a[i] = make_float64(random_bits(64));
+        b[i] = make_float64(random_bits(64));
+        r[i] = ops[op].f64(a[i], b[i], &qsf);
+    }
+    memcpy(v, b, sizeof(v));
+    ops[op].f64_n(v, a, v, N, &vsf);
+
+    for (i = 0; i < N; i++) {
+        check(ops[op].name, 64, mode, i, float64_val(r[i]), float64_val(v[i]),
+              i == N - 1 ? get_float_exception_flags(&qsf) : 0,
+              i == N - 1 ? get_float_exception_flags(&vsf) : 0);
+    }
+}
+
+int main(int ac, char **av)
+{
+    int i, op, mode;
+
+    for (i = 0; i < 2000; i++) {
+        for (op = 0; op < ARRAY_SIZE(ops); op++) {
+            for (mode = 0; mode < ARRAY_SIZE(modes); mode++) {
+                test_f32(op, mode, i & 1);
+                test_f64(op, mode, i & 1);
+            }
+        }
+    }
+    return errors != 0;
+}
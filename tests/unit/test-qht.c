@@ -69,7 +69,9 @@ static void rm_nonexist(int init, int end)
 
 static void check(int a, int b, bool expected)
 {
+    struct qht_lookup_stats lookup_stats = {};
     struct qht_stats stats;
+    size_t n_stats = 0;
     int i;
 
     rcu_read_lock();
@@ -80,16 +82,24 @@ static void check(int a, int b, bool expected)
 
         val = i;
         hash = i;
-        /* test both lookup variants; results should be the same */
-        if (i % 2) {
+        /* test all lookup variants; results should be the same */
+        if (i % 3 == 1) {
             p = qht_lookup(&ht, &val, hash);
-        } else {
+        } else if (i % 3 == 2) {
             p = qht_lookup_custom(&ht, &val, hash, is_equal);
+        } else {
+            p = qht_lookup_custom_stats(&ht, &val, hash, is_equal,
+                                        &lookup_stats);
+            n_stats++;
         }
         g_assert_true(!!p == expected);
     }
     rcu_read_unlock();
 
+    g_assert_cmpuint(lookup_stats.lookups, ==, n_stats);
+    g_assert_cmpuint(lookup_stats.probes, >=, n_stats);
+    g_assert_cmpuint(lookup_stats.retries, ==, 0);
+
     qht_statistics_init(&ht, &stats);
     if (stats.used_head_buckets) {
         g_assert_cmpfloat(qdist_avg(&stats.chain), >=, 1.0);